@@ -0,0 +1,71 @@
+#include "matcher.hpp"
+#include "order_ingress.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Matcher throughput vs. batch size: one producer feeds the ingress, the matcher
+// takes up to `batch` orders per pop_batch and matches them under one book lock
+// (the same loop shape as matcher_func). Batch size 1 is the old one-at-a-time loop.
+// Reports orders/s and the mean per-order match time recorded by match_batch.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int ORDERS = 1000000;
+
+// Mostly passive quotes around 100.00, with every 8th order crossing the spread
+static Order make_order(int i) {
+    bool buy = i % 2 == 0;
+    int offset = (i / 2) % 16;
+    Price price = buy ? Price(9990 - offset) : Price(10010 + offset);
+    if (i % 8 == 7) price = buy ? Price(10030) : Price(9970);
+    return Order(i + 1, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, price, 1 + i % 5);
+}
+
+static void run(size_t batch_size) {
+    BookConfig config;
+    config.max_orders = ORDERS;
+    OrderBook book(config);
+    Matcher matcher;
+    OrderIngress ingress(1);
+    std::mutex book_mutex;   // stands in for the GUI/matcher mutex in main.cpp
+
+    std::vector<Order> batch(batch_size, Order(0, 0, Side::BUY, OrderType::LIMIT, Price(), 0));
+    std::vector<double> match_ns(batch_size);
+    double total_match_ns = 0;
+
+    auto t0 = clock_type::now();
+    std::thread producer([&] {
+        size_t lane = ingress.register_producer();
+        for (int i = 0; i < ORDERS; ++i) ingress.push(lane, make_order(i));
+    });
+    int matched = 0;
+    while (matched < ORDERS) {
+        size_t n = ingress.pop_batch(batch, batch_size);
+        if (n == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(book_mutex);
+            matcher.match_batch(std::span<Order>(batch.data(), n), book, match_ns);
+        }
+        for (size_t i = 0; i < n; ++i) total_match_ns += match_ns[i];
+        matched += n;
+    }
+    producer.join();
+    double seconds = std::chrono::duration<double>(clock_type::now() - t0).count();
+    std::printf("%zu,%.2f,%.1f\n", batch_size, ORDERS / seconds / 1e6, total_match_ns / ORDERS);
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    std::printf("batch_size,throughput_morders_s,match_ns_per_order\n");
+    for (size_t batch : { 1, 4, 16, 64, 256 }) run(batch);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include "order_book.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Measures the cost of cancelling an order from a single price level as the
+// level depth grows. With intrusive per-level lists the cost should stay flat.
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    const int depths[] = { 1, 10, 100, 1000, 10000, 100000 };
+    const int cancels = 100000;
+    const Price price = Price::from_double(100.0);
+    std::mt19937 rng(42);
+
+    std::printf("depth,cancel_ns\n");
+    for (int depth : depths) {
+        OrderBook book;
+        int next_id = 1;
+        std::vector<int> live;
+        for (int i = 0; i < depth; ++i) {
+            book.add_order(Order(next_id, next_id, Side::SELL, OrderType::LIMIT, price, 1));
+            live.push_back(next_id++);
+        }
+
+        // Cancel a random resting order and replace it so the depth stays constant.
+        // Only the cancel itself is timed.
+        long long total_ns = 0;
+        for (int i = 0; i < cancels; ++i) {
+            size_t slot = rng() % live.size();
+            auto t0 = std::chrono::steady_clock::now();
+            book.cancel_order(live[slot]);
+            auto t1 = std::chrono::steady_clock::now();
+            total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+            book.add_order(Order(next_id, next_id, Side::SELL, OrderType::LIMIT, price, 1));
+            live[slot] = next_id++;
+        }
+        std::printf("%d,%.1f\n", depth, (double)total_ns / cancels);
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "engine.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Multi-symbol replay through the Engine: PRODUCERS threads submit a pre-generated
+// stream spread round-robin over SYMBOLS symbols, and the engine matches it with
+// 1..8 shard threads. Reports wall time and orders/s from the first submit until
+// every order is matched. Shards only scale with free cores: on a machine with
+// fewer cores than producers + shards the extra threads just time-slice.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int ORDERS = 1000000;
+constexpr uint32_t SYMBOLS = 64;
+constexpr int PRODUCERS = 2;
+
+// Per symbol: mostly passive quotes around 100.00, every 8th order crossing the spread
+static Order make_order(int i) {
+    int k = i / SYMBOLS;
+    bool buy = k % 2 == 0;
+    int offset = (k / 2) % 16;
+    Price price = buy ? Price(9990 - offset) : Price(10010 + offset);
+    if (k % 8 == 7) price = buy ? Price(10030) : Price(9970);
+    Order o(i + 1, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, price, 1 + k % 5);
+    o.symbol_id = i % SYMBOLS;
+    return o;
+}
+
+static void run(size_t shards, const std::vector<Order>& stream) {
+    EngineConfig config;
+    config.symbols = SYMBOLS;
+    config.shards = shards;
+    config.max_producers = PRODUCERS;
+    config.publish_snapshots = false;
+    Engine engine(config);
+    engine.start();
+
+    auto t0 = clock_type::now();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            size_t id = engine.register_producer();
+            for (size_t i = p; i < stream.size(); i += PRODUCERS) engine.submit(id, stream[i]);
+        });
+    }
+    for (auto& t : producers) t.join();
+    engine.stop();
+    double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+    std::printf("%zu,%llu,%.3f,%.0f\n", shards, (unsigned long long)engine.matched(), secs, engine.matched() / secs);
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    std::vector<Order> stream;
+    stream.reserve(ORDERS);
+    for (int i = 0; i < ORDERS; ++i) stream.push_back(make_order(i));
+
+    std::printf("# %d orders over %u symbols, %d producers, %u hardware threads\n",
+                ORDERS, SYMBOLS, PRODUCERS, std::thread::hardware_concurrency());
+    std::printf("shards,orders,seconds,orders_per_sec\n");
+    for (size_t shards : {1, 2, 4, 8}) run(shards, stream);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "order.hpp"
+#include "order_ingress.hpp"
+#include "thread_safe_queue.hpp"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Ingress throughput with 1 to 32 producer threads feeding one consumer:
+// a single shared ThreadSafeQueue vs. OrderIngress (one SPSC lane per producer,
+// merged round-robin). The consumer also checks per-producer FIFO order.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int TOTAL_ORDERS = 2000000;
+
+// Order ids encode producer and per-producer sequence
+static Order make_order(int producer, int seq) {
+    return Order(producer * 10000000 + seq, 0, Side::BUY, OrderType::LIMIT, Price(10000), 1);
+}
+
+static void check_fifo(std::vector<int>& last_seq, const Order& o) {
+    int producer = o.order_id / 10000000, seq = o.order_id % 10000000;
+    if (seq != last_seq[producer] + 1) std::fprintf(stderr, "producer %d out of order\n", producer);
+    last_seq[producer] = seq;
+}
+
+static double run_locked(int producers) {
+    ThreadSafeQueue<Order> queue;
+    int per_producer = TOTAL_ORDERS / producers;
+    std::vector<int> last_seq(producers, -1);
+    auto t0 = clock_type::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < per_producer; ++i) queue.push(make_order(p, i));
+        });
+    }
+    for (int i = 0; i < per_producer * producers; ++i) check_fifo(last_seq, queue.pop());
+    for (auto& t : threads) t.join();
+    return per_producer * producers / std::chrono::duration<double>(clock_type::now() - t0).count() / 1e6;
+}
+
+static double run_ingress(int producers) {
+    OrderIngress ingress(producers);
+    int per_producer = TOTAL_ORDERS / producers;
+    std::vector<int> last_seq(producers, -1);
+    auto t0 = clock_type::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            size_t lane = ingress.register_producer();
+            for (int i = 0; i < per_producer; ++i) ingress.push(lane, make_order((int)lane, i));
+        });
+    }
+    for (int i = 0; i < per_producer * producers; ++i) check_fifo(last_seq, ingress.pop());
+    for (auto& t : threads) t.join();
+    return per_producer * producers / std::chrono::duration<double>(clock_type::now() - t0).count() / 1e6;
+}
+
+int main() {
+    std::printf("producers,thread_safe_queue_mmsg_s,order_ingress_mmsg_s\n");
+    for (int producers : { 1, 2, 4, 8, 16, 32 }) {
+        double locked = run_locked(producers);
+        double lanes = run_ingress(producers);
+        std::printf("%d,%.2f,%.2f\n", producers, locked, lanes);
+    }
+    return 0;
+}
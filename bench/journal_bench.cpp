@@ -0,0 +1,64 @@
+#include "engine.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+// Journal overhead on one shard: ORDERS limit orders (every 8th crossing, every 16th
+// message a cancel) from one producer, with no journal and with each durability mode,
+// single-threaded and pipelined. Reports throughput from first submit to last match,
+// and the journal's group commits (write + fdatasync) and records per group.
+// The journal lives in DIR; put it on the disk you care about (tmpfs makes fdatasync free).
+
+using clock_type = std::chrono::steady_clock;
+constexpr int ORDERS = 1000000;
+const char* DIR = "/tmp/lob_journal_bench";
+
+static OrderMessage make_message(int i) {
+    int id = i + 1;
+    if (i % 16 == 15) return OrderMessage::cancel(0, id - 8);
+    bool buy = i % 2 == 0;
+    int offset = (i / 2) % 16;
+    Price price = buy ? Price(9990 - offset) : Price(10010 + offset);
+    if (i % 8 == 7) price = buy ? Price(10030) : Price(9970);
+    return OrderMessage::new_order(Order(id, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, price, 1 + i % 5));
+}
+
+static void run(bool pipelined, const char* mode, const Durability* durability) {
+    std::filesystem::remove_all(DIR);
+    EngineConfig config;
+    config.pipelined = pipelined;
+    config.publish_snapshots = false;
+    config.book.max_orders = ORDERS;
+    if (durability) {
+        config.journal.dir = DIR;
+        config.journal.durability = *durability;
+        config.journal.segment_bytes = size_t(256) << 20;
+    }
+    Engine engine(config);
+    engine.start();
+    size_t producer = engine.register_producer();
+    auto t0 = clock_type::now();
+    for (int i = 0; i < ORDERS; ++i) engine.submit(producer, make_message(i));
+    while (engine.matched() < uint64_t(ORDERS)) std::this_thread::yield();
+    double seconds = std::chrono::duration<double>(clock_type::now() - t0).count();
+    engine.stop();
+    JournalStats js = engine.journal_stats();
+    std::printf("%s,%s,%.0f,%llu,%.1f\n", pipelined ? "pipelined" : "single", mode, ORDERS / seconds,
+                (unsigned long long)js.groups, js.groups ? double(js.records) / js.groups : 0.0);
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    std::printf("# %u hardware threads, journal in %s\n", std::thread::hardware_concurrency(), DIR);
+    std::printf("shard,journal,msgs_per_s,group_commits,records_per_group\n");
+    for (bool pipelined : {false, true}) {
+        run(pipelined, "off", nullptr);
+        for (Durability d : {Durability::NONE, Durability::ASYNC, Durability::SYNC}) run(pipelined, to_string(d), &d);
+    }
+    std::filesystem::remove_all(DIR);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "latency_metrics.hpp"
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// LatencyMetrics: per-thread HDR histograms vs. the previous mutex + std::deque<double>
+// recorder (kept below). Reports the per-call cost of add() with 1 to 4 recording
+// threads, and the cost of one dashboard read: avg+min+max (three locked scans) for
+// the deque, summary() (one merge, all percentiles) for the histograms.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int ADDS = 2000000;
+
+// The previous recorder: bounded sample deque behind a mutex
+class DequeMetrics {
+    std::deque<double> samples;
+    size_t max_samples;
+    std::mutex mtx;
+public:
+    DequeMetrics(size_t max_samples_ = 1000) : max_samples(max_samples_) {}
+    void add(double v) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (samples.size() >= max_samples) samples.pop_front();
+        samples.push_back(v);
+    }
+    double avg() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (samples.empty()) return 0.0;
+        return std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    }
+    double min() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+    }
+    double max() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+    }
+};
+
+template <typename Metrics>
+static double add_ns(Metrics& m, int threads) {
+    auto t0 = clock_type::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < ADDS / threads; ++i) m.add(0.5 + (i * 7 + t) % 1000 * 0.01);
+        });
+    }
+    for (auto& w : workers) w.join();
+    return std::chrono::duration<double, std::nano>(clock_type::now() - t0).count() / ADDS;
+}
+
+template <typename Read>
+static double read_us(Read read) {
+    const int reads = 2000;
+    volatile double sink = 0;
+    auto t0 = clock_type::now();
+    for (int i = 0; i < reads; ++i) sink = sink + read();
+    return std::chrono::duration<double, std::micro>(clock_type::now() - t0).count() / reads;
+}
+
+int main() {
+    std::printf("# %u hardware threads\n", std::thread::hardware_concurrency());
+    std::printf("recorder,threads,add_ns,read_us\n");
+    for (int threads : {1, 2, 4}) {
+        DequeMetrics old_metrics(500);
+        double add = add_ns(old_metrics, threads);
+        double read = read_us([&] { return old_metrics.avg() + old_metrics.min() + old_metrics.max(); });
+        std::printf("deque_mutex,%d,%.1f,%.2f\n", threads, add, read);
+
+        LatencyMetrics metrics;
+        add = add_ns(metrics, threads);
+        read = read_us([&] { return metrics.summary().p99; });
+        std::printf("hdr_per_thread,%d,%.1f,%.2f\n", threads, add, read);
+    }
+
+    // Accuracy check on the last histogram: uniform 0.5..10.49 us
+    LatencyMetrics metrics;
+    for (int i = 0; i < 1000000; ++i) metrics.add(0.5 + i % 1000 * 0.01);
+    LatencySummary s = metrics.summary();
+    std::printf("# uniform 0.5..10.49 us: p50 %.3f p99 %.3f p99.99 %.3f max %.3f mean %.3f\n",
+                s.p50, s.p99, s.p9999, s.max, s.mean);
+    return 0;
+}
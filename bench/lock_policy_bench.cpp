@@ -0,0 +1,75 @@
+#include "matcher.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Cost of the book's lock policy:
+//  - add_cancel: one thread quoting and cancelling through the public API (one lock per call)
+//  - match:      one thread sending a crossing order flow through Matcher::match_order
+//  - contended:  two threads quoting/cancelling on the same book (thread-safe policies only)
+// Built with logging compiled out so the lock is not hidden behind log calls.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int OPS = 2000000;
+
+template <typename Book>
+static double add_cancel(Book& book, int first_id, int ops) {
+    auto t0 = clock_type::now();
+    for (int i = 0; i < ops / 2; ++i) {
+        int id = first_id + i;
+        book.add_order(Order(id, 0, i % 2 ? Side::BUY : Side::SELL, OrderType::LIMIT,
+                             i % 2 ? Price(9990 - i % 8) : Price(10010 + i % 8), 1));
+        book.cancel_order(id);
+    }
+    return std::chrono::duration<double, std::nano>(clock_type::now() - t0).count() / ops;
+}
+
+template <typename L>
+static void run(const char* name, bool thread_safe) {
+    BookConfig config;
+    config.max_orders = 1 << 20;
+    double quote_ns, match_ns, contended_ns = 0;
+    {
+        BasicOrderBook<L> book(config);
+        quote_ns = add_cancel(book, 1, OPS);
+    }
+    {
+        BasicOrderBook<L> book(config);
+        Matcher matcher;
+        auto t0 = clock_type::now();
+        for (int i = 0; i < OPS; ++i) {
+            bool buy = i % 2 == 0;
+            Price price = buy ? Price(10000 + (i % 4 == 0)) : Price(10000 - (i % 4 == 1));
+            Order o(i + 1, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, price, 1);
+            matcher.match_order(o, book);
+        }
+        match_ns = std::chrono::duration<double, std::nano>(clock_type::now() - t0).count() / OPS;
+    }
+    if (thread_safe) {
+        BasicOrderBook<L> book(config);
+        auto t0 = clock_type::now();
+        std::thread other([&] { add_cancel(book, 1 << 28, OPS / 2); });
+        add_cancel(book, 1, OPS / 2);
+        other.join();
+        contended_ns = std::chrono::duration<double, std::nano>(clock_type::now() - t0).count() / OPS;
+    }
+    if (thread_safe) {
+        std::printf("%s,%.1f,%.1f,%.1f\n", name, quote_ns, match_ns, contended_ns);
+    } else {
+        std::printf("%s,%.1f,%.1f,n/a\n", name, quote_ns, match_ns);
+    }
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    std::printf("policy,add_cancel_ns_per_op,match_ns_per_order,contended_ns_per_op\n");
+    run<NullLock>("null_lock", false);
+    run<SpinLock>("spin_lock", true);
+    run<std::mutex>("std_mutex", true);
+    return 0;
+}
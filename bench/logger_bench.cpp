@@ -0,0 +1,47 @@
+#include "utils/logger.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// Cost per call site of a 4-argument fill message: the async logger versus the
+// std::cout << ... << std::endl it replaced. Console output goes to /dev/null.
+// Log calls are timed in bursts that fit the per-thread ring, with a flush between
+// bursts so no record is dropped.
+static volatile int sink_id = 7;
+
+int main() {
+    std::ofstream devnull("/dev/null");
+    std::streambuf* console = std::cout.rdbuf(devnull.rdbuf());
+
+    const int burst = LogRing::CAPACITY / 2;
+    const int bursts = 100;
+    using clock = std::chrono::steady_clock;
+
+    // Warm-up: registers this thread's ring and starts the background thread
+    LOG_INFO("warm-up {}", 0);
+    Logger::instance().flush();
+
+    std::chrono::nanoseconds logger_time{0};
+    for (int b = 0; b < bursts; ++b) {
+        auto t0 = clock::now();
+        for (int i = 0; i < burst; ++i) {
+            LOG_INFO("Matched Order {} with Order {} at Price {} for Quantity {}", i, sink_id, 100.25, 3);
+        }
+        logger_time += clock::now() - t0;
+        Logger::instance().flush();
+    }
+
+    auto t0 = clock::now();
+    for (int i = 0; i < burst * bursts / 10; ++i) {
+        std::cout << "Matched Order " << i << " with Order " << sink_id
+                  << " at Price " << 100.25 << " for Quantity " << 3 << std::endl;
+    }
+    std::chrono::nanoseconds cout_time = clock::now() - t0;
+
+    std::cout.rdbuf(console);
+    std::printf("sink,ns_per_call\n");
+    std::printf("async_logger,%.1f\n", std::chrono::duration<double, std::nano>(logger_time).count() / (burst * bursts));
+    std::printf("cout_endl,%.1f\n", std::chrono::duration<double, std::nano>(cout_time).count() / (burst * bursts / 10));
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "order_book.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+// Sweep cost of the side-generic OrderBook::match against the previous matcher loop,
+// which picked the price comparison at run time from the order's type and side on
+// every level. Takers alternate sides and mix LIMIT and MARKET orders; each sweeps
+// `levels` price levels of `per_level` one-lot orders. Only the matching call is timed.
+
+// The matching loop as it was before OrderBook::match (console and CSV output removed).
+template <typename Ladder>
+static void legacy_match(Order& incoming, Ladder& opposite_book, OrderBook& book) {
+    while (!opposite_book.empty() && incoming.quantity > 0) {
+        Price price_level = opposite_book.best_price();
+        bool price_match = false;
+        if (incoming.type == OrderType::MARKET) price_match = true;
+        else if (incoming.side == Side::BUY) price_match = (incoming.price >= price_level);
+        else price_match = (incoming.price <= price_level);
+        if (!price_match) break;
+        OrderList& level = opposite_book.best();
+        while (!level.empty() && incoming.quantity > 0) {
+            OrderHandle top = level.front();
+            OrderNode& resting = book.orders[top];
+            int trade_qty = std::min(incoming.quantity, resting.quantity);
+            incoming.quantity -= trade_qty;
+            level.reduce(book.orders, top, trade_qty);
+            book.orders.cold(top).filled += trade_qty;
+            book.record_trade(price_level);
+            if (resting.quantity == 0) {
+                level.erase(book.orders, top);
+                book.release_order(top);
+            }
+            incoming.status = incoming.quantity == 0 ? OrderStatus::FILLED : OrderStatus::PARTIALLY_FILLED;
+        }
+        if (level.empty()) {
+            opposite_book.erase(price_level);
+        }
+    }
+}
+
+static volatile long long sink;
+
+template <bool Legacy>
+static double run(int levels, int per_level, int rounds) {
+    BookConfig config;
+    config.max_orders = levels * per_level + 1024;
+    OrderBook book(config);
+    std::mt19937 rng(5);
+    int next_id = 1;
+    long long fills = 0;
+    std::chrono::nanoseconds total{0};
+
+    for (int r = 0; r < rounds; ++r) {
+        Side taker_side = r % 2 ? Side::BUY : Side::SELL;
+        Side maker_side = taker_side == Side::BUY ? Side::SELL : Side::BUY;
+        for (int l = 0; l < levels; ++l) {
+            Price p = taker_side == Side::BUY ? Price(10000 + l) : Price(10000 - l);
+            for (int i = 0; i < per_level; ++i) {
+                book.add_order(Order(next_id++, 0, maker_side, OrderType::LIMIT, p, 1));
+            }
+        }
+        OrderType type = rng() % 2 ? OrderType::MARKET : OrderType::LIMIT;
+        Price limit = taker_side == Side::BUY ? Price(10000 + levels) : Price(10000 - levels);
+        Order taker(next_id++, 0, taker_side, type, limit, levels * per_level);
+
+        auto t0 = std::chrono::steady_clock::now();
+        if constexpr (Legacy) {
+            // match() takes the book lock; hold it here too so both pay the same
+            std::lock_guard lock(book.book_mutex);
+            if (taker_side == Side::BUY) legacy_match(taker, book.sell_book, book);
+            else legacy_match(taker, book.buy_book, book);
+        } else {
+            auto no_report = [](int, Price, int) {};
+            if (taker_side == Side::BUY) book.match<Side::BUY>(taker, no_report);
+            else book.match<Side::SELL>(taker, no_report);
+        }
+        total += std::chrono::steady_clock::now() - t0;
+        fills += levels * per_level;
+    }
+    sink = fills;
+    return std::chrono::duration<double, std::nano>(total).count() / fills;
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    const int fills_per_case = 2000000;
+    std::printf("levels,orders_per_level,legacy_ns_per_fill,generic_ns_per_fill\n");
+    for (int levels : { 1, 10, 100 }) {
+        for (int per_level : { 1, 10 }) {
+            int rounds = fills_per_case / (levels * per_level);
+            double legacy = run<true>(levels, per_level, rounds);
+            double generic = run<false>(levels, per_level, rounds);
+            std::printf("%d,%d,%.1f,%.1f\n", levels, per_level, legacy, generic);
+        }
+    }
+    return 0;
+}
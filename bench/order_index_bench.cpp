@@ -0,0 +1,73 @@
+#include "order_index.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// Insert, lookup and erase cost of the order index at 1M, 10M and 50M live orders:
+// std::unordered_map (the previous index), the open-addressing table, and the
+// direct-indexed mode. Sizes can be overridden on the command line.
+
+struct UnorderedIndex {
+    std::unordered_map<int, OrderHandle> map;
+    explicit UnorderedIndex(size_t n) { map.reserve(n); }
+    void insert(int id, OrderHandle h) { map[id] = h; }
+    OrderHandle find(int id) const { auto it = map.find(id); return it == map.end() ? NULL_HANDLE : it->second; }
+    void erase(int id) { map.erase(id); }
+};
+
+struct HashIndex : OrderIndex {
+    explicit HashIndex(size_t n) : OrderIndex(IndexMode::HASH, n) {}
+};
+
+struct DirectIndex : OrderIndex {
+    explicit DirectIndex(size_t n) : OrderIndex(IndexMode::DIRECT, n) {}
+};
+
+static volatile unsigned long long sink;
+
+template <typename Index>
+static void run(const char* name, size_t live) {
+    using clock = std::chrono::steady_clock;
+    const size_t ops = 1000000;
+    std::mt19937 rng(11);
+    std::vector<int> probe(ops);
+    for (auto& id : probe) id = 1 + rng() % live;
+
+    Index index(live);
+    auto t0 = clock::now();
+    for (size_t id = 1; id <= live; ++id) index.insert((int)id, (OrderHandle)id);
+    auto t1 = clock::now();
+
+    unsigned long long sum = 0;
+    for (int id : probe) sum += index.find(id);
+    auto t2 = clock::now();
+
+    // Erase random live ids, then put them back so the table stays at `live`
+    for (int id : probe) index.erase(id);
+    auto t3 = clock::now();
+    for (int id : probe) index.insert(id, (OrderHandle)id);
+
+    auto ns = [](clock::time_point a, clock::time_point b, size_t n) {
+        return std::chrono::duration<double, std::nano>(b - a).count() / n;
+    };
+    sink = sum;
+    std::printf("%zu,%s,%.1f,%.1f,%.1f\n", live, name, ns(t0, t1, live), ns(t1, t2, ops), ns(t2, t3, ops));
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes = { 1000000, 10000000, 50000000 };
+    if (argc > 1) {
+        sizes.clear();
+        for (int i = 1; i < argc; ++i) sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    std::printf("live_orders,index,insert_ns,lookup_ns,erase_ns\n");
+    for (size_t live : sizes) {
+        run<UnorderedIndex>("unordered_map", live);
+        run<HashIndex>("flat_hash", live);
+        run<DirectIndex>("direct", live);
+    }
+    return 0;
+}
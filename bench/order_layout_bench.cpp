@@ -0,0 +1,126 @@
+#include "order_store.hpp"
+#include "order_list.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <numeric>
+#include <random>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+// Sweeps deep price levels the way the matcher does (walk the FIFO, read quantity)
+// and compares the old layout, a full Order plus pointers per node, against the
+// packed 32-byte hot record with cold fields in a side table.
+// Cache misses come from perf_event_open when the kernel allows it.
+
+// Layout used before the hot/cold split
+struct FatNode {
+    Order order;
+    FatNode* prev = nullptr;
+    FatNode* next = nullptr;
+    explicit FatNode(const Order& o) : order(o) {}
+};
+
+// Hardware counter for the calling thread, or a no-op if perf events are unavailable
+class PerfCounter {
+    int fd = -1;
+public:
+    PerfCounter(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~PerfCounter() { if (fd >= 0) close(fd); }
+    void start() { if (fd >= 0) { ioctl(fd, PERF_EVENT_IOC_RESET, 0); ioctl(fd, PERF_EVENT_IOC_ENABLE, 0); } }
+    long long stop() {
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long value = 0;
+        if (read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+        return value;
+    }
+};
+
+struct Result { double ns_per_order; long long l1_misses; long long llc_misses; };
+
+template <typename Sweep>
+static Result measure(Sweep&& sweep, int orders, int repeats) {
+    PerfCounter l1(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    PerfCounter llc(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    l1.start();
+    llc.start();
+    auto t0 = std::chrono::steady_clock::now();
+    long long checksum = 0;
+    for (int r = 0; r < repeats; ++r) checksum += sweep();
+    auto t1 = std::chrono::steady_clock::now();
+    long long l1_misses = l1.stop();
+    long long llc_misses = llc.stop();
+    if (checksum == 42) std::printf(" ");  // keep the sweep observable
+    double total = (double)orders * repeats;
+    return { std::chrono::duration<double, std::nano>(t1 - t0).count() / total,
+             l1_misses < 0 ? -1 : (long long)(l1_misses / total * 1000),
+             llc_misses < 0 ? -1 : (long long)(llc_misses / total * 1000) };
+}
+
+int main() {
+    const int LEVELS = 8;  // other levels interleave with the swept one in memory
+    std::mt19937 rng(1);
+    std::printf("sizeof(FatNode)=%zu sizeof(OrderNode)=%zu\n", sizeof(FatNode), sizeof(OrderNode));
+    std::printf("depth,layout,ns_per_order,l1d_misses_per_1k,llc_misses_per_1k\n");
+
+    for (int depth : { 1000, 10000, 100000 }) {
+        int total = depth * LEVELS;
+        // Arrival order: orders for all levels interleaved randomly
+        std::vector<int> level_of(total);
+        for (int i = 0; i < total; ++i) level_of[i] = i % LEVELS;
+        std::shuffle(level_of.begin(), level_of.end(), rng);
+
+        // Old layout: one heap node per order, allocated in arrival order
+        std::vector<FatNode*> fat(total);
+        FatNode* fat_head = nullptr;
+        FatNode* fat_tail = nullptr;
+        for (int i = 0; i < total; ++i) {
+            fat[i] = new FatNode(Order(i, i, Side::SELL, OrderType::LIMIT, Price(10000 + level_of[i]), 1 + i % 7));
+            if (level_of[i] != 0) continue;
+            fat[i]->prev = fat_tail;
+            if (fat_tail) fat_tail->next = fat[i]; else fat_head = fat[i];
+            fat_tail = fat[i];
+        }
+
+        // Hot/cold layout: handles into OrderStore, level 0 linked through the hot records
+        OrderStore store(total);
+        OrderList level;
+        for (int i = 0; i < total; ++i) {
+            OrderHandle h = store.acquire(Order(i, i, Side::SELL, OrderType::LIMIT, Price(10000 + level_of[i]), 1 + i % 7));
+            if (level_of[i] == 0) level.push_back(store, h);
+        }
+
+        int repeats = std::max(1, 2000000 / depth);
+        Result fat_result = measure([&] {
+            long long qty = 0;
+            for (FatNode* n = fat_head; n; n = n->next) qty += n->order.quantity - n->order.filled;
+            return qty;
+        }, depth, repeats);
+        Result hot_result = measure([&] {
+            long long qty = 0;
+            for (OrderHandle h = level.front(); h != NULL_HANDLE; h = store[h].next) qty += store[h].quantity;
+            return qty;
+        }, depth, repeats);
+
+        std::printf("%d,fat,%.2f,%lld,%lld\n", depth, fat_result.ns_per_order, fat_result.l1_misses, fat_result.llc_misses);
+        std::printf("%d,hot,%.2f,%lld,%lld\n", depth, hot_result.ns_per_order, hot_result.l1_misses, hot_result.llc_misses);
+        for (FatNode* n : fat) delete n;
+    }
+    std::printf("(miss counts of -1 mean perf events are not available)\n");
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "engine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Overload behaviour per ingress overflow policy: PRODUCERS threads each fire a burst
+// of BURST new orders (every 16th message a cancel) at one shard as fast as they can,
+// which outruns the matcher. Reports what the ingress did with the burst and the
+// queueing delay (submit to end of match) of the orders that were matched.
+// Lane capacity is CAPACITY messages, so BLOCK bounds memory by stalling producers,
+// REJECT by refusing, and DROP_OLDEST_NON_CANCEL by discarding stale orders.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int PRODUCERS = 4;
+constexpr int BURST = 100000;
+constexpr size_t CAPACITY = 1024;
+
+static long long now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+}
+
+static OrderMessage make_message(int producer, int i) {
+    int id = producer * BURST + i + 1;
+    if (i % 16 == 15) return OrderMessage::cancel(0, id - 8);
+    bool buy = i % 2 == 0;
+    int offset = (i / 2) % 16;
+    Price price = buy ? Price(9990 - offset) : Price(10010 + offset);
+    if (i % 8 == 7) price = buy ? Price(10030) : Price(9970);
+    return OrderMessage::new_order(Order(id, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, price, 1 + i % 5));
+}
+
+static void run(OverflowPolicy policy) {
+    std::vector<double> delay_us;
+    delay_us.reserve(PRODUCERS * BURST);
+    EngineConfig config;
+    config.max_producers = PRODUCERS;
+    config.publish_snapshots = false;
+    config.book.max_orders = PRODUCERS * BURST;
+    config.ingress.capacity = CAPACITY;
+    config.ingress.overflow = policy;
+    config.on_matched = [&](const Order& o) { delay_us.push_back((now_ns() - o.timestamp) / 1000.0); };
+    Engine engine(config);
+    engine.start();
+
+    auto t0 = clock_type::now();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            size_t id = engine.register_producer();
+            for (int i = 0; i < BURST; ++i) {
+                OrderMessage m = make_message(p, i);
+                m.order.timestamp = now_ns();
+                engine.submit(id, m);
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+    double burst_ms = std::chrono::duration<double, std::milli>(clock_type::now() - t0).count();
+    engine.stop();
+
+    IngressStats s = engine.ingress_stats();
+    std::sort(delay_us.begin(), delay_us.end());
+    auto pct = [&](double p) { return delay_us.empty() ? 0.0 : delay_us[std::min(delay_us.size() - 1, size_t(p * delay_us.size()))]; };
+    std::printf("%s,%.1f,%llu,%llu,%llu,%llu,%.1f,%.1f,%.1f\n", to_string(policy), burst_ms,
+                (unsigned long long)s.accepted, (unsigned long long)s.rejected, (unsigned long long)s.shed,
+                (unsigned long long)s.max_depth, pct(0.5), pct(0.99), delay_us.empty() ? 0.0 : delay_us.back());
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    std::printf("policy,burst_ms,accepted,rejected,shed,max_lane_depth,delay_p50_us,delay_p99_us,delay_max_us\n");
+    for (OverflowPolicy policy : {OverflowPolicy::BLOCK, OverflowPolicy::REJECT, OverflowPolicy::DROP_OLDEST_NON_CANCEL}) {
+        run(policy);
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "engine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Single-threaded shard vs. the pipelined (validate -> sequence -> match -> publish)
+// shard on one symbol. One producer submits ORDERS limit orders (every 8th crossing,
+// every 16th message a cancel) back to back; reports throughput from first submit to
+// the last order published and the submit-to-publish latency of new orders.
+// The pipelined shard needs four cores to itself to pay off; on fewer cores its
+// stages time-share with the producer.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int ORDERS = 1000000;
+
+static long long now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+}
+
+static OrderMessage make_message(int i) {
+    int id = i + 1;
+    if (i % 16 == 15) return OrderMessage::cancel(0, id - 8);
+    bool buy = i % 2 == 0;
+    int offset = (i / 2) % 16;
+    Price price = buy ? Price(9990 - offset) : Price(10010 + offset);
+    if (i % 8 == 7) price = buy ? Price(10030) : Price(9970);
+    return OrderMessage::new_order(Order(id, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, price, 1 + i % 5));
+}
+
+static void run(bool pipelined) {
+    std::vector<double> latency_us;
+    latency_us.reserve(ORDERS);
+    EngineConfig config;
+    config.pipelined = pipelined;
+    config.wait = WaitStrategy::SPIN_YIELD;   // Pure spinning starves the other stages when cores are short
+    config.publish_snapshots = false;
+    config.book.max_orders = ORDERS;
+    config.on_matched = [&](const Order& o) { latency_us.push_back((now_ns() - o.timestamp) / 1000.0); };
+    Engine engine(config);
+    engine.start();
+
+    size_t producer = engine.register_producer();
+    auto t0 = clock_type::now();
+    for (int i = 0; i < ORDERS; ++i) {
+        OrderMessage m = make_message(i);
+        m.order.timestamp = now_ns();
+        engine.submit(producer, m);
+    }
+    while (engine.matched() < uint64_t(ORDERS)) std::this_thread::yield();
+    double seconds = std::chrono::duration<double>(clock_type::now() - t0).count();
+    engine.stop();
+
+    std::sort(latency_us.begin(), latency_us.end());
+    auto pct = [&](double p) { return latency_us[std::min(latency_us.size() - 1, size_t(p * latency_us.size()))]; };
+    std::printf("%s,%.0f,%.1f,%.1f,%.1f\n", pipelined ? "pipelined" : "single",
+                ORDERS / seconds, pct(0.5), pct(0.99), latency_us.back());
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    std::printf("# %u hardware threads\n", std::thread::hardware_concurrency());
+    std::printf("shard,msgs_per_s,latency_p50_us,latency_p99_us,latency_max_us\n");
+    run(false);
+    run(true);
+    return 0;
+}
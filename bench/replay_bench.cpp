@@ -0,0 +1,149 @@
+#include "csv_replay.hpp"
+#include "engine.hpp"
+#include "event_file.hpp"
+#include "mapped_file.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Order-flow replay: writes EVENTS synthetic events (1 in 16 a cancel, 1 in 32 a
+// modify) to a temporary file, then reports GB/s and messages/s for
+//  - getline_stod: std::getline + std::stringstream field split + std::stod (baseline)
+//  - mmap_parse:   MappedFile + CsvOrderParser into a no-op sink
+//  - mmap_engine:  the same replay feeding one engine shard, until all are matched
+//  - mmap_bin_*:   the same two with the events converted to the binary event format
+//  - mmap_paced:   PACED mode at 2x over 10 us recorded gaps, against the due time
+
+using clock_type = std::chrono::steady_clock;
+constexpr int EVENTS = 2000000;
+const char* PATH = "/tmp/lob_replay_bench.csv";
+const char* BIN_PATH = "/tmp/lob_replay_bench.bin";
+
+static void write_file(int events, long long gap_ns) {
+    std::FILE* f = std::fopen(PATH, "w");
+    std::fprintf(f, "timestamp_ns,action,order_id,symbol,side,type,price,quantity,stop_price\n");
+    for (int i = 0; i < events; ++i) {
+        long long ts = 1700000000000000000LL + i * gap_ns;
+        int id = i + 1;
+        if (i % 16 == 15) {
+            std::fprintf(f, "%lld,C,%d,0,,,,,\n", ts, id - 8);
+        } else if (i % 32 == 7) {
+            std::fprintf(f, "%lld,M,%d,0,,,%d.%02d,%d,\n", ts, id - 4, 99 + i % 2, i % 100, 1 + i % 9);
+        } else {
+            bool buy = i % 2 == 0;
+            int cents = buy ? 9990 - (i / 2) % 16 : 10010 + (i / 2) % 16;
+            if (i % 8 == 6) cents = buy ? 10030 : 9970;
+            std::fprintf(f, "%lld,A,%d,0,%c,L,%d.%02d,%d,\n", ts, id, buy ? 'B' : 'S', cents / 100, cents % 100, 1 + i % 5);
+        }
+    }
+    std::fclose(f);
+}
+
+static void report(const char* name, const ReplayStats& s) {
+    std::printf("%s,%llu,%.3f,%.0f\n", name, (unsigned long long)s.messages, s.gb_per_s(), s.msgs_per_s());
+}
+
+// The straightforward reader the mmap parser replaces
+static ReplayStats getline_stod() {
+    ReplayStats stats;
+    auto t0 = clock_type::now();
+    std::ifstream in(PATH);
+    std::string line, field;
+    std::getline(in, line);
+    stats.bytes += line.size() + 1;
+    double checksum = 0;
+    while (std::getline(in, line)) {
+        stats.bytes += line.size() + 1;
+        std::stringstream ss(line);
+        for (int column = 0; std::getline(ss, field, ','); ++column) {
+            if (column == 6 && !field.empty()) checksum += std::stod(field);
+            else if (column == 7 && !field.empty()) checksum += std::stoi(field);
+        }
+        ++stats.messages;
+    }
+    stats.seconds = std::chrono::duration<double>(clock_type::now() - t0).count();
+    if (checksum == 42) std::printf("#\n");
+    return stats;
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    write_file(EVENTS, 1000);
+    std::printf("# %u hardware threads\n", std::thread::hardware_concurrency());
+    std::printf("reader,messages,gb_per_s,msgs_per_s\n");
+    report("getline_stod", getline_stod());
+
+    {
+        MappedFile file(PATH);
+        CsvOrderParser parser(file.data(), file.end());
+        int64_t checksum = 0;
+        ReplayStats s = replay(parser, [&](const OrderMessage& m) { checksum += m.order.price.ticks + m.order.quantity; return true; });
+        if (checksum == 42) std::printf("#\n");
+        report("mmap_parse", s);
+    }
+    {
+        EngineConfig config;
+        config.publish_snapshots = false;
+        config.book.max_orders = EVENTS;
+        Engine engine(config);
+        engine.start();
+        size_t producer = engine.register_producer();
+        MappedFile file(PATH);
+        CsvOrderParser parser(file.data(), file.end());
+        auto t0 = clock_type::now();
+        ReplayStats s = replay(parser, [&](const OrderMessage& m) { engine.submit(producer, m); return true; });
+        while (engine.matched() < s.messages) std::this_thread::yield();
+        s.seconds = std::chrono::duration<double>(clock_type::now() - t0).count();   // Until all are matched
+        engine.stop();
+        report("mmap_engine", s);
+    }
+    {
+        // The same events as a binary event file
+        {
+            MappedFile csv(PATH);
+            CsvOrderParser parser(csv.data(), csv.end());
+            EventFileWriter writer(BIN_PATH, {"SYM0"});
+            OrderMessage m = OrderMessage::cancel(0, 0);
+            while (parser.next(m)) writer.append(m);
+            writer.close();
+        }
+        MappedFile file(BIN_PATH);
+        EventFileReader reader(file.data(), file.size());
+        int64_t checksum = 0;
+        ReplayStats s = replay(reader, [&](const OrderMessage& m) { checksum += m.order.price.ticks + m.order.quantity; return true; });
+        if (checksum == 42) std::printf("#\n");
+        report("mmap_bin_read", s);
+
+        EngineConfig config;
+        config.publish_snapshots = false;
+        config.book.max_orders = EVENTS;
+        Engine engine(config);
+        engine.start();
+        size_t producer = engine.register_producer();
+        EventFileReader engine_reader(file.data(), file.size());
+        auto t0 = clock_type::now();
+        s = replay(engine_reader, [&](const OrderMessage& m) { engine.submit(producer, m); return true; });
+        while (engine.matched() < s.messages) std::this_thread::yield();
+        s.seconds = std::chrono::duration<double>(clock_type::now() - t0).count();
+        engine.stop();
+        report("mmap_bin_engine", s);
+        std::remove(BIN_PATH);
+    }
+    {
+        // 20k events recorded 10 us apart, replayed 2x faster: due after ~100 ms
+        write_file(20000, 10000);
+        MappedFile file(PATH);
+        CsvOrderParser parser(file.data(), file.end());
+        ReplayStats s = replay(parser, [](const OrderMessage&) { return true; }, ReplayMode::PACED, 2.0);
+        report("mmap_paced", s);
+        std::printf("# paced: due after %.3f ms, took %.3f ms\n", (20000 - 1) * 1e-2 / 2.0, s.seconds * 1e3);
+    }
+    std::remove(PATH);
+    return 0;
+}
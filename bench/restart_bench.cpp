@@ -0,0 +1,96 @@
+#include "engine.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+// Restart time of one shard holding a book of ORDERS resting limit orders: replaying the
+// whole journal, vs. loading a snapshot taken at 90% and replaying the last 10%, vs. a
+// snapshot of the full book. Also reports the matcher's stall for each snapshot (the
+// fork) and how long the child took to write it. Only one engine is alive at a time.
+// The journal and snapshots live in DIR; put it on the disk you care about.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int ORDERS = 10000000;
+const char* DIR = "/tmp/lob_restart_bench";
+
+static EngineConfig make_config() {
+    EngineConfig config;
+    config.publish_snapshots = false;
+    config.book.max_orders = ORDERS;
+    config.book.index_mode = IndexMode::DIRECT;
+    config.journal.dir = DIR;
+    config.journal.durability = Durability::NONE;   // Restart cost, not write cost
+    config.journal.segment_bytes = size_t(256) << 20;
+    return config;
+}
+
+// Resting only: bids on 1000 levels below 100.00, asks on 1000 levels above
+static void submit(Engine& engine, size_t producer, int first, int last) {
+    for (int i = first; i < last; ++i) {
+        bool buy = i % 2 == 0;
+        int offset = (i / 2) % 1000;
+        Price price = buy ? Price(9999 - offset) : Price(10001 + offset);
+        engine.submit(producer, Order(i + 1, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, price, 1 + i % 5));
+    }
+    while (engine.matched() < uint64_t(last)) std::this_thread::yield();
+}
+
+static void snapshot(Engine& engine, uint64_t written) {
+    auto t0 = clock_type::now();
+    engine.request_snapshot();
+    while (engine.snapshot_stats().written < written) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    SnapshotStats ss = engine.snapshot_stats();
+    std::printf("# snapshot of %llu orders: fork stall %llu us, written in %.2f s\n",
+                (unsigned long long)(engine.restored() + engine.recovered() + engine.matched()),
+                (unsigned long long)ss.max_fork_us, std::chrono::duration<double>(clock_type::now() - t0).count());
+}
+
+// Construction (preallocating the book) is timed apart from start(), which does the recovery
+static void restart(const char* name) {
+    auto t0 = clock_type::now();
+    Engine engine(make_config());
+    auto t1 = clock_type::now();
+    engine.start();
+    auto t2 = clock_type::now();
+    engine.stop();
+    std::printf("%s,%llu,%llu,%.2f,%.2f\n", name, (unsigned long long)engine.restored(),
+                (unsigned long long)engine.recovered(), std::chrono::duration<double>(t1 - t0).count(),
+                std::chrono::duration<double>(t2 - t1).count());
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    std::filesystem::remove_all(DIR);
+    std::printf("# %u hardware threads, journal and snapshots in %s\n", std::thread::hardware_concurrency(), DIR);
+    {
+        Engine engine(make_config());
+        engine.start();
+        size_t producer = engine.register_producer();
+        submit(engine, producer, 0, ORDERS / 10 * 9);
+        snapshot(engine, 1);
+        submit(engine, producer, ORDERS / 10 * 9, ORDERS);
+        engine.stop();
+    }
+    std::printf("restart,orders_restored,messages_replayed,construct_s,start_s\n");
+    restart("snapshot_90pct_plus_tail");
+
+    // Hide the snapshot to time a journal-only restart
+    std::string path = list_snapshots(DIR, 0).back().second;
+    std::filesystem::rename(path, path + ".hidden");
+    restart("journal_only");
+    std::filesystem::rename(path + ".hidden", path);
+
+    {
+        Engine engine(make_config());
+        engine.start();
+        snapshot(engine, 1);
+        engine.stop();
+    }
+    restart("snapshot_full");
+    std::filesystem::remove_all(DIR);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "matcher.hpp"
+#include "seqlock.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Matcher batch latency (p50/p99/max) while a dashboard-like reader runs at ~500 Hz:
+//  - none:    no reader
+//  - locked:  reader and matcher share a mutex (the old global book_mutex); the reader
+//             reads depth and stops and keeps it for 500 us of "layout", as run_gui did
+//  - seqlock: the reader copies the published BookSnapshot and lays out without a lock
+// The matcher publishes a snapshot after every batch of 64 orders in all modes.
+
+using clock_type = std::chrono::steady_clock;
+enum class Reader { NONE, LOCKED, SEQLOCK };
+
+static Order make_order(int i) {
+    bool buy = i % 2 == 0;
+    int offset = (i / 2) % 16;
+    Price price = buy ? Price(9990 - offset) : Price(10010 + offset);
+    if (i % 8 == 7) price = buy ? Price(10030) : Price(9970);
+    return Order(i + 1, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, price, 1 + i % 5);
+}
+
+static void run(const char* name, Reader mode) {
+    const int batches = 20000;
+    const size_t batch_size = 64;
+    BookConfig config;
+    config.max_orders = batches * batch_size;
+    OrderBook book(config);
+    Matcher matcher;
+    Seqlock<BookSnapshot> view;
+    std::mutex gui_mutex;
+    std::atomic<bool> done{false};
+
+    std::thread reader([&] {
+        static BookSnapshot copy;
+        while (!done.load(std::memory_order_relaxed)) {
+            if (mode == Reader::LOCKED) {
+                std::lock_guard<std::mutex> lock(gui_mutex);
+                auto bids = book.depth(Side::BUY, BookSnapshot::LEVELS);
+                auto asks = book.depth(Side::SELL, BookSnapshot::LEVELS);
+                auto stops = book.pending_stops(BookSnapshot::STOPS);
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            } else if (mode == Reader::SEQLOCK) {
+                view.load(copy);
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(1500));
+        }
+    });
+
+    static BookSnapshot snapshot;
+    std::vector<Order> batch;
+    std::vector<double> batch_us(batches);
+    int next = 0;
+    for (int b = 0; b < batches; ++b) {
+        batch.clear();
+        for (size_t i = 0; i < batch_size; ++i) batch.push_back(make_order(next++));
+        auto t0 = clock_type::now();
+        if (mode == Reader::LOCKED) {
+            std::lock_guard<std::mutex> lock(gui_mutex);
+            matcher.match_batch(batch, book);
+        } else {
+            matcher.match_batch(batch, book);
+        }
+        book.snapshot(snapshot);
+        view.store(snapshot);
+        batch_us[b] = std::chrono::duration<double, std::micro>(clock_type::now() - t0).count();
+    }
+    done = true;
+    reader.join();
+
+    std::sort(batch_us.begin(), batch_us.end());
+    std::printf("%s,%.1f,%.1f,%.1f\n", name, batch_us[batches / 2], batch_us[batches * 99 / 100], batch_us.back());
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    std::printf("reader,batch_p50_us,batch_p99_us,batch_max_us\n");
+    run("none", Reader::NONE);
+    run("locked", Reader::LOCKED);
+    run("seqlock", Reader::SEQLOCK);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "order.hpp"
+#include "spsc_ring.hpp"
+#include "thread_safe_queue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Order hand-off between two threads: SpscRing vs. the mutex/condvar ThreadSafeQueue.
+//  - throughput: one producer streams orders to one consumer
+//  - round trip: ping-pong of one order through a pair of queues (p50/p99)
+// Spinning sides yield, so the numbers stay meaningful on machines with few cores.
+
+using clock_type = std::chrono::steady_clock;
+constexpr size_t RING_SIZE = 1 << 14;
+
+static Order make_order(int id) {
+    return Order(id, id, Side::BUY, OrderType::LIMIT, Price(10000), 1);
+}
+
+// Uniform blocking interface over both queues
+struct RingQueue {
+    SpscRing<Order, RING_SIZE> ring;
+    void push(const Order& o) { while (!ring.try_push(o)) std::this_thread::yield(); }
+    Order pop() {
+        Order o = make_order(0);
+        while (!ring.try_pop(o)) std::this_thread::yield();
+        return o;
+    }
+};
+
+struct LockedQueue {
+    ThreadSafeQueue<Order> queue;
+    void push(const Order& o) { queue.push(o); }
+    Order pop() { return queue.pop(); }
+};
+
+template <typename Q>
+static double throughput(int messages) {
+    Q q;
+    auto t0 = clock_type::now();
+    std::thread consumer([&] {
+        for (int i = 0; i < messages; ++i) {
+            if (q.pop().order_id != i) std::fprintf(stderr, "out of order at %d\n", i);
+        }
+    });
+    for (int i = 0; i < messages; ++i) q.push(make_order(i));
+    consumer.join();
+    double seconds = std::chrono::duration<double>(clock_type::now() - t0).count();
+    return messages / seconds / 1e6;
+}
+
+template <typename Q>
+static void round_trip(int trips, double& p50, double& p99) {
+    Q ping, pong;
+    std::thread echo([&] {
+        for (int i = 0; i < trips; ++i) pong.push(ping.pop());
+    });
+    std::vector<double> ns(trips);
+    for (int i = 0; i < trips; ++i) {
+        auto t0 = clock_type::now();
+        ping.push(make_order(i));
+        pong.pop();
+        ns[i] = std::chrono::duration<double, std::nano>(clock_type::now() - t0).count();
+    }
+    echo.join();
+    std::sort(ns.begin(), ns.end());
+    p50 = ns[trips / 2];
+    p99 = ns[trips * 99 / 100];
+}
+
+template <typename Q>
+static void run(const char* name) {
+    double mps = throughput<Q>(2000000);
+    double p50, p99;
+    round_trip<Q>(100000, p50, p99);
+    std::printf("%s,%.2f,%.0f,%.0f\n", name, mps, p50, p99);
+}
+
+int main() {
+    std::printf("queue,throughput_mmsg_s,rtt_p50_ns,rtt_p99_ns\n");
+    run<LockedQueue>("thread_safe_queue");
+    run<RingQueue>("spsc_ring");
+    return 0;
+}
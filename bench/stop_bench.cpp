@@ -0,0 +1,53 @@
+#include "order_book.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+// Per-message cost of quoting around the market with a growing number of resting
+// stop orders that are not crossed, plus the cost of firing all of them at once.
+// With the price-sorted stop index the quoting cost should not depend on stop count.
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    const int messages = 200000;
+    std::printf("resting_stops,quote_ns_per_msg,fire_all_ns_per_stop\n");
+    for (int stops : { 0, 1000, 10000, 100000 }) {
+        BookConfig config;
+        config.max_orders = stops + 1024;
+        OrderBook book(config);
+        int next_id = 1;
+
+        // Market around 100.00; buy stops above 110, sell stops below 90
+        book.add_order(Order(next_id++, 0, Side::SELL, OrderType::LIMIT, Price(10001), 1000000));
+        book.add_order(Order(next_id++, 0, Side::BUY, OrderType::LIMIT, Price(9999), 1000000));
+        for (int i = 0; i < stops; ++i) {
+            bool buy = i % 2 == 0;
+            Price stop = buy ? Price(11000 + i % 500) : Price(9000 - i % 500);
+            book.add_order(Order(next_id++, 0, buy ? Side::BUY : Side::SELL, OrderType::STOP, Price(), 1, stop));
+        }
+
+        // Quote and cancel inside the spread; best bid/ask move on every message
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < messages / 2; ++i) {
+            int id = next_id++;
+            Side side = i % 2 ? Side::BUY : Side::SELL;
+            book.add_order(Order(id, 0, side, OrderType::LIMIT, Price(10000), 1));
+            book.cancel_order(id);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double quote_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / messages;
+
+        // Move both quotes through every stop level: all stops fire
+        auto t2 = std::chrono::steady_clock::now();
+        book.add_order(Order(next_id++, 0, Side::BUY, OrderType::LIMIT, Price(8000), 1000000));
+        book.add_order(Order(next_id++, 0, Side::SELL, OrderType::LIMIT, Price(12000), 1000000));
+        book.cancel_order(1);
+        book.cancel_order(2);
+        auto t3 = std::chrono::steady_clock::now();
+        double fire_ns = stops ? std::chrono::duration<double, std::nano>(t3 - t2).count() / stops : 0.0;
+
+        std::printf("%d,%.1f,%.1f\n", stops, quote_ns, fire_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "matcher.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Per-order match time on one NullLock book, every second order filling the one
+// before it, with fills:
+//  - none:  not recorded
+//  - csv:   formatted into an ofstream CSV inside the timed region, as Matcher did
+//           before the trade tape (kept below)
+//  - tape:  appended to a TradeTape, written out by its own thread
+// Reports percentiles of the per-order time and, for the tape, its write() calls.
+// Files go to DIR. Logging compiled out.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int ORDERS = 2000000;
+const char* DIR = "/tmp/lob_tape_bench";
+
+static Order make_order(int i) {
+    bool buy = i % 2 == 0;
+    Order o(i + 1, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, Price(10000), 1 + i / 2 % 5);
+    return o;
+}
+
+template <typename Match>
+static void run(const char* name, Match&& match, const TradeTape* tape = nullptr) {
+    BookConfig config;
+    config.max_orders = 1 << 16;
+    BasicOrderBook<NullLock> book(config);
+    std::vector<double> ns(ORDERS);
+    auto start = clock_type::now();
+    for (int i = 0; i < ORDERS; ++i) {
+        Order o = make_order(i);
+        auto t0 = clock_type::now();
+        match(o, book);
+        ns[i] = std::chrono::duration<double, std::nano>(clock_type::now() - t0).count();
+    }
+    double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::sort(ns.begin(), ns.end());
+    auto at = [&](double q) { return ns[std::min<size_t>(ns.size() - 1, size_t(q * ns.size()))]; };
+    std::printf("%s,%.0f,%.0f,%.0f,%.0f,%.0f,", name, ORDERS / seconds, at(0.5), at(0.99), at(0.999), ns.back());
+    if (tape) {
+        TradeTapeStats s = tape->stats();   // Approximate: the tape may still be writing
+        std::printf("%llu,%llu\n", (unsigned long long)s.records, (unsigned long long)s.writes);
+    } else {
+        std::printf(",\n");
+    }
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    std::filesystem::remove_all(DIR);
+    std::filesystem::create_directories(DIR);
+    std::printf("# %u hardware threads, files in %s\n", std::thread::hardware_concurrency(), DIR);
+    std::printf("fills,orders_per_s,p50_ns,p99_ns,p999_ns,max_ns,tape_records,tape_writes\n");
+
+    Matcher plain;
+    run("none", [&](Order& o, BasicOrderBook<NullLock>& book) { plain.match_order(o, book); });
+
+    // The previous fill log: one formatted CSV line per fill, timed with the match
+    std::ofstream csv(std::string(DIR) + "/latency.csv");
+    csv << "incoming_id,matched_id,price,quantity,latency_ns\n";
+    run("csv", [&](Order& o, BasicOrderBook<NullLock>& book) {
+        auto start = std::chrono::high_resolution_clock::now();
+        Matcher::match_order(o, book, [&](int matched_id, Price price, int qty) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+            csv << o.order_id << "," << matched_id << "," << price.to_double(book.tick_size) << "," << qty << "," << ns << "\n";
+        });
+    });
+    csv.close();
+
+    TradeTapeConfig config;
+    config.dir = DIR;
+    TradeTape tape(config, 0, DEFAULT_TICK_SIZE);
+    Matcher taped(&tape);
+    run("tape", [&](Order& o, BasicOrderBook<NullLock>& book) { taped.match_order(o, book); }, &tape);
+    tape.close();
+    std::filesystem::remove_all(DIR);
+    return 0;
+}
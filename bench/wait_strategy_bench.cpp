@@ -0,0 +1,84 @@
+#include "engine.hpp"
+#include "thread_config.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// End-to-end latency per matcher wait strategy: one producer submits an order, then
+// sleeps GAP_US, so the matcher goes idle between orders the way it does under light
+// live flow. Latency runs from just before submit() to the end of that order's match
+// on the shard thread (Engine's on_matched hook). cpu_s is the process CPU time of the
+// run, which shows what the spinning strategies cost while idle.
+// Thread placement follows the LOB_PRODUCER_CPUS / LOB_MATCHER_CPUS variables used by
+// the dashboard; note that SPIN shares its core with the producer if both are unpinned
+// on a single-core machine.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int ORDERS = 20000;
+constexpr int GAP_US = 50;
+
+static long long now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+}
+
+// Mostly passive quotes around 100.00, with every 8th order crossing the spread
+static Order make_order(int i) {
+    bool buy = i % 2 == 0;
+    int offset = (i / 2) % 16;
+    Price price = buy ? Price(9990 - offset) : Price(10010 + offset);
+    if (i % 8 == 7) price = buy ? Price(10030) : Price(9970);
+    return Order(i + 1, 0, buy ? Side::BUY : Side::SELL, OrderType::LIMIT, price, 1 + i % 5);
+}
+
+static void run(WaitStrategy wait, const ThreadConfig& threads) {
+    std::vector<double> latency_us;
+    latency_us.reserve(ORDERS);
+    EngineConfig config;
+    config.shards = 1;
+    config.max_producers = 1;
+    config.publish_snapshots = false;
+    config.book.max_orders = ORDERS;
+    config.wait = wait;
+    config.spin_polls = threads.spin_polls;
+    config.shard_cpus = threads.matcher_cpus;
+    config.on_matched = [&](const Order& o) { latency_us.push_back((now_ns() - o.timestamp) / 1000.0); };
+    Engine engine(config);
+    engine.start();
+
+    std::clock_t cpu0 = std::clock();
+    std::thread producer([&] {
+        pin_current_thread(cpu_for(threads.producer_cpus, 0));
+        size_t id = engine.register_producer();
+        for (int i = 0; i < ORDERS; ++i) {
+            Order o = make_order(i);
+            o.timestamp = now_ns();
+            engine.submit(id, o);
+            std::this_thread::sleep_for(std::chrono::microseconds(GAP_US));
+        }
+    });
+    producer.join();
+    engine.stop();
+    double cpu_s = double(std::clock() - cpu0) / CLOCKS_PER_SEC;
+
+    std::sort(latency_us.begin(), latency_us.end());
+    auto pct = [&](double p) { return latency_us[std::min(latency_us.size() - 1, size_t(p * latency_us.size()))]; };
+    std::printf("%s,%.2f,%.2f,%.2f,%.2f,%.2f\n", to_string(wait), pct(0.5), pct(0.99), pct(0.999),
+                latency_us.back(), cpu_s);
+}
+
+int main() {
+    // Silence the per-event console output of the book
+    std::cout.setstate(std::ios::badbit);
+
+    ThreadConfig threads = ThreadConfig::from_env();
+    std::printf("# %d orders, one every %d us, %u hardware threads\n", ORDERS, GAP_US, std::thread::hardware_concurrency());
+    std::printf("wait,p50_us,p99_us,p99.9_us,max_us,cpu_s\n");
+    for (WaitStrategy wait : {WaitStrategy::BLOCKING, WaitStrategy::SPIN, WaitStrategy::SPIN_YIELD, WaitStrategy::SPIN_PARK}) {
+        run(wait, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+// Debug/test allocation accounting. Linking src/alloc_counter.cpp replaces the
+// global operator new with a version that counts allocations per thread, so a test
+// can assert that the matching thread stays off the heap once the book is warm.
+
+// Number of global operator new calls made by the calling thread so far.
+size_t thread_allocations();
+
+// Counts allocations made by the current thread while the guard is alive.
+class AllocGuard {
+    size_t start;
+public:
+    AllocGuard() : start(thread_allocations()) {}
+    size_t count() const { return thread_allocations() - start; }
+};
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "order_message.hpp"
+#include "replay.hpp"
+
+// Historical order flow as CSV, one event per line after an optional header line:
+//
+//   timestamp_ns,action,order_id,symbol,side,type,price,quantity,stop_price
+//
+//  - action: A (add), C (cancel) or M (modify)
+//  - side:   B or S;  type: L (limit), M (market), S (stop) or T (stop-limit)
+//  - price, stop_price: decimals ("100.05"), rounded to ticks of the parser's tick size
+//  - cancels leave side..stop_price empty; modifies only use price and quantity
+// Blank lines and lines starting with '#' are skipped. See data/sample_orders.csv.
+
+// Zero-allocation parser over a byte range (typically a MappedFile). Each line is
+// found with memchr and its fields are read in one forward pass; digit loops stop
+// on the first non-digit and single-character fields refuse to step over it, so the
+// '\n' ending the line bounds them without length checks. Throws std::runtime_error naming the line on malformed input.
+class CsvOrderParser {
+public:
+    static constexpr size_t MAX_LINE = 256;
+
+    CsvOrderParser(const char* begin, const char* end, double tick_size = DEFAULT_TICK_SIZE)
+        : first(begin), pos(begin), last(end), tick_units(std::llround(tick_size * PRICE_SCALE)) {
+        if (tick_units <= 0) throw std::invalid_argument("tick size below price resolution");
+    }
+
+    // Parse the next event into `out`; false once the input is exhausted.
+    bool next(OrderMessage& out) {
+        while (pos < last) {
+            ++line_no;
+            const char* line = pos;
+            const char* eol = static_cast<const char*>(std::memchr(pos, '\n', last - pos));
+            if (eol) {
+                pos = eol + 1;
+            } else {
+                // Last line without a newline: terminate a copy so the field loops stay unchecked
+                size_t n = last - pos;
+                if (n >= MAX_LINE) error("line too long");
+                std::memcpy(tail, pos, n);
+                tail[n] = '\n';
+                line = tail;
+                eol = tail + n;
+                pos = last;
+            }
+            if (line == eol || *line == '#' || *line == '\r') continue;
+            if (line_no == 1 && digit(*line) > 9) continue;   // header
+            parse(line, out);
+            return true;
+        }
+        return false;
+    }
+
+    size_t line() const { return line_no; }                  // Lines consumed so far
+    size_t bytes_consumed() const { return pos - first; }
+
+private:
+    static constexpr int64_t PRICE_SCALE = 100000000;   // Decimals are read to 1e-8
+
+    const char* first;
+    const char* pos;
+    const char* last;
+    int64_t tick_units;    // Tick size in 1e-8 units
+    size_t line_no = 0;
+    char tail[MAX_LINE + 1];
+
+    static unsigned digit(char c) { return unsigned(c) - '0'; }
+
+    [[noreturn]] void error(const char* what) const {
+        throw std::runtime_error("line " + std::to_string(line_no) + ": " + what);
+    }
+
+    void expect(const char*& p, char c) const {
+        if (*p != c) error("unexpected character");
+        ++p;
+    }
+    // One-character field; the line's '\n' is never stepped over
+    char field(const char*& p) const {
+        if (*p == '\n') error("missing field");
+        return *p++;
+    }
+    void expect_end(const char* p) const {
+        if (*p == '\r') ++p;
+        if (*p != '\n') error("trailing characters");
+    }
+
+    static uint64_t number(const char*& p) {
+        uint64_t v = 0;
+        for (unsigned d; (d = digit(*p)) < 10; ++p) v = v * 10 + d;
+        return v;
+    }
+
+    // Decimal to ticks, rounded to nearest; an empty field reads as 0
+    int64_t price(const char*& p) const {
+        bool negative = *p == '-';
+        p += negative;
+        int64_t units = int64_t(number(p)) * PRICE_SCALE;
+        if (*p == '.') {
+            ++p;
+            int64_t scale = PRICE_SCALE;
+            for (unsigned d; (d = digit(*p)) < 10; ++p) {
+                scale /= 10;
+                units += d * scale;   // digits past 1e-8 add nothing
+            }
+        }
+        int64_t ticks = (units + tick_units / 2) / tick_units;
+        return negative ? -ticks : ticks;
+    }
+
+    static void skip_field(const char*& p) {
+        while (*p != ',' && *p != '\n') ++p;
+    }
+
+    void parse(const char* p, OrderMessage& out) const {
+        long long timestamp = (long long)number(p);
+        expect(p, ',');
+        char action = field(p);
+        expect(p, ',');
+        int order_id = int(number(p));
+        expect(p, ',');
+        uint32_t symbol = uint32_t(number(p));
+
+        if (action == 'C') {
+            out = OrderMessage::cancel(symbol, order_id);
+        } else if (action == 'M') {
+            expect(p, ',');
+            skip_field(p);
+            expect(p, ',');
+            skip_field(p);
+            expect(p, ',');
+            Price new_price(price(p));
+            expect(p, ',');
+            int quantity = int(number(p));
+            out = OrderMessage::modify(symbol, order_id, new_price, quantity);
+        } else if (action == 'A') {
+            expect(p, ',');
+            char side = field(p);
+            expect(p, ',');
+            char type = field(p);
+            expect(p, ',');
+            Price limit(price(p));
+            expect(p, ',');
+            int quantity = int(number(p));
+            Price stop;
+            if (*p == ',') {
+                ++p;
+                stop = Price(price(p));
+            }
+            if (side != 'B' && side != 'S') error("side must be B or S");
+            OrderType order_type;
+            switch (type) {
+                case 'L': order_type = OrderType::LIMIT; break;
+                case 'M': order_type = OrderType::MARKET; break;
+                case 'S': order_type = OrderType::STOP; break;
+                case 'T': order_type = OrderType::STOP_LIMIT; break;
+                default: error("type must be L, M, S or T");
+            }
+            Order order(order_id, timestamp, side == 'B' ? Side::BUY : Side::SELL, order_type, limit, quantity, stop);
+            order.symbol_id = symbol;
+            out = OrderMessage::new_order(order);
+            expect_end(p);
+            return;
+        } else {
+            error("action must be A, C or M");
+        }
+        out.order.timestamp = timestamp;
+        skip_field(p);   // cancels and modifies may carry the remaining columns
+        while (*p == ',') {
+            ++p;
+            skip_field(p);
+        }
+        expect_end(p);
+    }
+};
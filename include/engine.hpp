@@ -0,0 +1,189 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+#include "order_book.hpp"
+#include "matcher.hpp"
+#include "order_ingress.hpp"
+#include "seqlock.hpp"
+#include "latency_metrics.hpp"
+#include "wait_strategy.hpp"
+#include "pipeline.hpp"
+#include "journal.hpp"
+#include "snapshot.hpp"
+#include "trade_tape.hpp"
+
+struct EngineConfig {
+    size_t symbols = 1;                    // Symbol ids are 0 .. symbols-1
+    size_t shards = 1;                     // Matcher threads; symbol s belongs to shard s % shards
+    size_t max_producers = 8;              // Threads that may call submit()
+    size_t batch = 64;                     // Messages a shard takes from its ingress per pass
+    IngressConfig ingress;                 // Per-lane bound and overflow policy of every shard
+    bool publish_snapshots = true;         // Publish each touched book's snapshot after a pass
+    WaitStrategy wait = WaitStrategy::SPIN_YIELD;  // How an idle shard waits for orders
+    unsigned spin_polls = 1000;            // Empty polls before SPIN_YIELD/SPIN_PARK back off
+    std::vector<int> shard_cpus;           // Thread k of the engine is pinned to shard_cpus[k % size]; empty = unpinned
+    bool pipelined = false;                // Run each shard as validate -> sequence -> match -> publish threads
+    int max_order_qty = 1000000;           // Risk limit: larger orders are rejected by validation
+    BookConfig book;                       // Sizing of every symbol's book
+    JournalConfig journal;                 // Write-ahead journal of each shard's sequenced input; off if dir is empty
+    SnapshotConfig snapshot;               // Book snapshots, written to the journal dir (needs a journal)
+    TradeTapeConfig tape;                  // Binary tape of every fill, per shard; off if dir is empty
+    LatencyMetrics* pop_latency = nullptr;    // Amortized ingress pop time per order (us), if set
+    LatencyMetrics* match_latency = nullptr;  // Match time per order (us), if set
+    std::function<void(const Order&)> on_matched;  // Called after each new order (publish stage if pipelined), if set
+};
+
+// Multi-symbol matching engine. Every symbol has its own book, owned by exactly one
+// matcher thread (its shard), so books run with NullLock. Producers dispatch directly
+// into the owning shard's ingress lane (one lane per producer per shard); there is no
+// router thread and no shared queue between shards.
+//
+// By default one thread per shard validates, matches and publishes. With `pipelined`
+// each shard runs four threads over a shared event ring, each advancing its own
+// cursor (see pipeline.hpp):
+//  - validate: takes messages from the ingress and applies the symbol and risk checks
+//  - sequence: numbers accepted messages in shard order and journals them
+//  - match:    the only thread touching the shard's books; fills go to a ring
+//  - publish:  trade tape and console output, rejections, on_matched, counters
+// Depth snapshots are still taken by the match stage once per batch, since only the
+// books' owner can read them without a lock.
+//
+// With a journal, every accepted message is numbered and appended to its shard's
+// write-ahead journal before it is matched (Durability::SYNC waits for the disk per
+// batch). Between batches, the thread owning a shard's books snapshots them when due:
+// it forks, and the child writes the copy-on-write image of the books at that
+// sequence while the parent carries on matching. The first start() loads each shard's
+// newest snapshot and replays only the journal after it.
+//
+// With a trade tape, every fill is also appended to its shard's TradeTape by the
+// thread that sees it (the shard's matcher, or the publish stage) and written out in
+// large blocks by the tape's own thread. Fills replayed from the journal are not taped again.
+class Engine {
+public:
+    using Book = BasicOrderBook<NullLock>;
+
+    explicit Engine(const EngineConfig& config);
+    ~Engine();
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Recover from the journal (first call only), then start the shard threads.
+    // Throws std::runtime_error if the journal cannot be read or opened.
+    void start();
+    // Match everything submitted before the call, then stop the shard threads.
+    void stop();
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    // Claim a producer id (one lane in every shard). Call once per producer thread.
+    size_t register_producer();
+    // Route a message to the shard owning its symbol; false if that lane is full.
+    bool try_submit(size_t producer, const OrderMessage& message);
+    bool try_submit(size_t producer, const Order& order) { return try_submit(producer, OrderMessage::new_order(order)); }
+    // As try_submit, but a full lane is handled by the configured overflow policy.
+    PushResult submit(size_t producer, const OrderMessage& message);
+    PushResult submit(size_t producer, const Order& order) { return submit(producer, OrderMessage::new_order(order)); }
+
+    size_t symbols() const { return books.size(); }
+    size_t shards() const { return shard_list.size(); }
+    size_t shard_of(uint32_t symbol) const { return symbol % shard_list.size(); }
+    double tick_size() const { return config.book.tick_size; }
+
+    // Latest published snapshot of a symbol's book; safe from any thread.
+    void snapshot(uint32_t symbol, BookSnapshot& out) const { views[symbol]->load(out); }
+    // The book itself; only safe to use while the engine is stopped.
+    Book& book(uint32_t symbol) { return *books[symbol]; }
+    // Messages processed so far, over all shards (shed ones excluded).
+    uint64_t matched() const;
+    // Ingress depth and overflow counters, over all shards.
+    IngressStats ingress_stats() const;
+    // Orders loaded from snapshots, and messages replayed from the journal, by start().
+    uint64_t restored() const { return restored_; }
+    uint64_t recovered() const { return recovered_; }
+    // Have every shard snapshot its books at its next batch boundary (needs a journal).
+    void request_snapshot();
+    // Snapshots finished or failed so far.
+    SnapshotStats snapshot_stats() const;
+    // Journal counters over all shards since construction; exact once stopped.
+    JournalStats journal_stats() const;
+    // Trade tape counters over all shards since construction; exact once stopped.
+    TradeTapeStats tape_stats() const;
+
+private:
+    struct Shard {
+        BasicOrderIngress<OrderMessage> ingress;
+        size_t index;
+        Matcher matcher;                   // Tapes fills while a tape is open
+        std::thread thread;                // The shard, or its validate stage if pipelined
+        IdleWaiter waiter;
+        std::atomic<uint64_t> processed{0};
+        std::unique_ptr<Pipeline> pipeline;
+        std::thread stages[3];             // Sequence, match and publish stages if pipelined
+        std::unique_ptr<Journal> journal;  // While running, if journaling
+        std::unique_ptr<TradeTape> tape;   // While running, if taping
+        uint64_t sequence = 0;             // Last accepted message's number; owned by the sequencing thread
+        uint64_t snapshot_sequence = 0;    // Of the last snapshot started; owned by the matching thread
+        std::atomic<bool> snapshot_requested{false};
+        std::atomic<bool> snapshot_running{false};   // A child is writing this shard's snapshot
+        Shard(size_t producers, const IngressConfig& ingress, size_t index, WaitStrategy wait, unsigned spin_polls)
+            : ingress(producers, ingress), index(index), waiter(wait, spin_polls) {}
+    };
+
+    EngineConfig config;
+    std::vector<std::unique_ptr<Book>> books;                     // Indexed by symbol id
+    std::vector<std::unique_ptr<Seqlock<BookSnapshot>>> views;    // Indexed by symbol id
+    std::vector<std::unique_ptr<Shard>> shard_list;
+    std::mutex register_mutex;
+    std::atomic<bool> running_{false};
+    bool journal_replayed = false;
+    uint64_t recovered_ = 0;
+    uint64_t restored_ = 0;
+    JournalStats closed_journals;          // Counters of journals closed by stop()
+    TradeTapeStats closed_tapes;           // Counters of tapes closed by stop()
+
+    // Snapshot children are reaped (and old files pruned) by a background thread
+    struct PendingSnapshot {
+        pid_t pid;
+        size_t shard;
+        uint64_t sequence;
+    };
+    std::thread reaper;
+    std::mutex reaper_mutex;
+    std::condition_variable reaper_cv;
+    std::deque<PendingSnapshot> pending_snapshots;
+    bool reaper_stopping = false;
+    std::atomic<uint64_t> snapshots_written{0}, snapshots_failed{0}, max_fork_us{0};
+
+    // Reason to reject a message before it reaches a book, or nullptr.
+    const char* check(const OrderMessage& message) const;
+    int cpu_of(const Shard& shard, size_t stage) const;
+    void publish_views(const std::vector<uint32_t>& symbols, BookSnapshot& scratch);
+    // Restore the newest snapshots and replay the journal after them (once), then open
+    // each shard's journal.
+    void open_journals();
+    // Load the newest valid snapshot of a shard into its books; returns its sequence.
+    uint64_t load_snapshot(Shard& shard);
+    // Matching thread, between batches: snapshot if requested or due.
+    void maybe_snapshot(Shard& shard, uint64_t applied);
+    void take_snapshot(Shard& shard, uint64_t sequence);
+    // Runs in the forked child; allocation-free.
+    bool write_snapshot(const Shard& shard, uint64_t sequence, const char* tmp_path, const char* path);
+    void run_reaper();
+
+    void run_shard(Shard& shard);
+    void run_validate(Shard& shard);
+    void run_sequence(Shard& shard);
+    void run_match(Shard& shard, uint64_t applied);   // applied: last sequence already in the books
+    void run_publish(Shard& shard);
+    // Loop of the stages after validate: process events as `upstream` releases them.
+    template <typename Process, typename Poll>
+    void run_stage(Shard& shard, StageCursor& upstream, StageCursor& own, Process&& process, Poll&& poll);
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "order_message.hpp"
+
+// Binary order-event file, the compact counterpart of the CSV replay format:
+//
+//   EventFileHeader                   64 bytes
+//   SymbolName[symbol_count]          16 bytes each, NUL padded
+//   (padding to records_offset, a multiple of 64)
+//   EventRecord[event_count]          40 bytes each
+//
+// Everything is fixed width and little-endian, so a reader on a little-endian host
+// uses the mapped bytes in place: no parsing and no copies, just one OrderMessage
+// built per record. Writers bump EVENT_FILE_VERSION on any layout change.
+static_assert(std::endian::native == std::endian::little, "event files are read in place");
+
+constexpr char EVENT_FILE_MAGIC[8] = {'L', 'O', 'B', 'E', 'V', 'E', 'N', 'T'};
+constexpr uint32_t EVENT_FILE_VERSION = 1;
+
+struct EventFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;       // sizeof(EventRecord) of the writer
+    uint64_t event_count;
+    uint64_t records_offset;    // Byte offset of the first record
+    uint32_t symbol_count;
+    uint32_t reserved;
+    double tick_size;           // Prices in the records are ticks of this size
+    uint8_t padding[16];
+};
+static_assert(sizeof(EventFileHeader) == 64);
+
+struct SymbolName {
+    char name[16];              // Record symbol i is symbol_table[i]
+};
+
+enum class EventKind : uint8_t { ADD_LIMIT = 1, ADD_MARKET, ADD_STOP, ADD_STOP_LIMIT, CANCEL, MODIFY };
+
+struct EventRecord {
+    int64_t timestamp_ns;
+    int64_t price;              // Ticks: limit price, or the new price of a MODIFY
+    int64_t stop_price;         // Ticks, stop orders only
+    int32_t order_id;
+    uint32_t symbol;            // Index into the symbol table
+    int32_t quantity;           // Order quantity, or the new quantity of a MODIFY
+    EventKind kind;
+    uint8_t side;               // 0 buy, 1 sell
+    uint8_t reserved[2];
+};
+static_assert(sizeof(EventRecord) == 40 && std::is_trivially_copyable_v<EventRecord>);
+
+inline EventRecord to_record(const OrderMessage& m) {
+    const Order& o = m.order;
+    EventRecord r{};
+    r.timestamp_ns = o.timestamp;
+    r.price = o.price.ticks;
+    r.stop_price = o.stop_price.ticks;
+    r.order_id = o.order_id;
+    r.symbol = o.symbol_id;
+    r.quantity = o.quantity;
+    r.side = o.side == Side::SELL;
+    switch (m.type) {
+        case MessageType::CANCEL: r.kind = EventKind::CANCEL; break;
+        case MessageType::MODIFY: r.kind = EventKind::MODIFY; break;
+        case MessageType::NEW:
+            r.kind = o.type == OrderType::LIMIT ? EventKind::ADD_LIMIT
+                   : o.type == OrderType::MARKET ? EventKind::ADD_MARKET
+                   : o.type == OrderType::STOP ? EventKind::ADD_STOP : EventKind::ADD_STOP_LIMIT;
+            break;
+    }
+    return r;
+}
+
+// Throws std::runtime_error on an unknown record kind.
+inline OrderMessage to_message(const EventRecord& r) {
+    OrderMessage m = OrderMessage::cancel(r.symbol, r.order_id);
+    switch (r.kind) {
+        case EventKind::CANCEL: break;
+        case EventKind::MODIFY: m = OrderMessage::modify(r.symbol, r.order_id, Price(r.price), r.quantity); break;
+        case EventKind::ADD_LIMIT:
+        case EventKind::ADD_MARKET:
+        case EventKind::ADD_STOP:
+        case EventKind::ADD_STOP_LIMIT: {
+            static constexpr OrderType types[] = {OrderType::LIMIT, OrderType::MARKET, OrderType::STOP, OrderType::STOP_LIMIT};
+            Order o(r.order_id, r.timestamp_ns, r.side ? Side::SELL : Side::BUY, types[uint8_t(r.kind) - 1],
+                    Price(r.price), r.quantity, Price(r.stop_price));
+            o.symbol_id = r.symbol;
+            m = OrderMessage::new_order(o);
+            break;
+        }
+        default: throw std::runtime_error("unknown event kind " + std::to_string(unsigned(r.kind)));
+    }
+    m.order.timestamp = r.timestamp_ns;
+    return m;
+}
+
+// Reads an event file in place from a byte range (typically a MappedFile, whose
+// page alignment keeps the records aligned). The constructor checks the magic,
+// version, record size and that the range holds every record; it throws
+// std::runtime_error otherwise. Iterate the records directly or use next() as a
+// replay() source.
+class EventFileReader {
+public:
+    EventFileReader(const char* data, size_t size) : base(data), length(size) {
+        if (!is_event_file(data, size)) throw std::runtime_error("not an event file");
+        std::memcpy(&head, data, sizeof(head));
+        if (head.version != EVENT_FILE_VERSION) throw std::runtime_error("unsupported event file version " + std::to_string(head.version));
+        if (head.record_size != sizeof(EventRecord)) throw std::runtime_error("event record size mismatch");
+        if (head.records_offset % alignof(EventRecord) != 0 ||
+            head.records_offset < sizeof(EventFileHeader) + uint64_t(head.symbol_count) * sizeof(SymbolName) ||
+            head.records_offset > size || (size - head.records_offset) / sizeof(EventRecord) < head.event_count) {
+            throw std::runtime_error("truncated event file");
+        }
+        first = reinterpret_cast<const EventRecord*>(data + head.records_offset);
+        cursor = first;
+    }
+
+    static bool is_event_file(const char* data, size_t size) {
+        return size >= sizeof(EventFileHeader) && std::memcmp(data, EVENT_FILE_MAGIC, sizeof(EVENT_FILE_MAGIC)) == 0;
+    }
+
+    const EventFileHeader& header() const { return head; }
+    double tick_size() const { return head.tick_size; }
+    size_t symbol_count() const { return head.symbol_count; }
+    std::string_view symbol(size_t i) const {
+        const char* name = base + sizeof(EventFileHeader) + i * sizeof(SymbolName);
+        return std::string_view(name, strnlen(name, sizeof(SymbolName)));
+    }
+
+    const EventRecord* begin() const { return first; }
+    const EventRecord* end() const { return first + head.event_count; }
+    size_t size() const { return head.event_count; }
+
+    // Next record as a message; false after the last one.
+    bool next(OrderMessage& out) {
+        if (cursor == end()) return false;
+        out = to_message(*cursor++);
+        return true;
+    }
+    size_t bytes_consumed() const { return head.records_offset + (cursor - first) * sizeof(EventRecord); }
+
+private:
+    const char* base;
+    size_t length;
+    EventFileHeader head;
+    const EventRecord* first;
+    const EventRecord* cursor;
+};
+
+// Writes an event file through a large stdio buffer; close() fills in the event
+// count. Throws std::runtime_error on I/O errors and on names or symbols that do
+// not fit the symbol table.
+class EventFileWriter {
+public:
+    EventFileWriter(const std::string& path, const std::vector<std::string>& symbols, double tick_size = DEFAULT_TICK_SIZE)
+        : file(std::fopen(path.c_str(), "wb")), symbol_count(uint32_t(symbols.size())) {
+        if (!file) throw std::runtime_error("cannot create " + path);
+        std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+        EventFileHeader head{};
+        std::memcpy(head.magic, EVENT_FILE_MAGIC, sizeof(head.magic));
+        head.version = EVENT_FILE_VERSION;
+        head.record_size = sizeof(EventRecord);
+        head.symbol_count = symbol_count;
+        head.tick_size = tick_size;
+        head.records_offset = (sizeof(EventFileHeader) + symbols.size() * sizeof(SymbolName) + 63) / 64 * 64;
+        write(&head, sizeof(head));
+        for (const std::string& s : symbols) {
+            SymbolName name{};
+            if (s.size() >= sizeof(name.name)) fail("symbol name too long: " + s);
+            std::memcpy(name.name, s.data(), s.size());
+            write(&name, sizeof(name));
+        }
+        static const char zeros[64] = {};
+        write(zeros, head.records_offset - sizeof(EventFileHeader) - symbols.size() * sizeof(SymbolName));
+    }
+    ~EventFileWriter() {
+        if (file) std::fclose(file);   // Unclosed: the count stays 0 and readers see no events
+    }
+
+    EventFileWriter(const EventFileWriter&) = delete;
+    EventFileWriter& operator=(const EventFileWriter&) = delete;
+
+    void append(const OrderMessage& m) {
+        if (m.order.symbol_id >= symbol_count) fail("symbol " + std::to_string(m.order.symbol_id) + " not in the symbol table");
+        EventRecord r = to_record(m);
+        write(&r, sizeof(r));
+        ++count;
+    }
+
+    void close() {
+        if (std::fseek(file, offsetof(EventFileHeader, event_count), SEEK_SET) != 0) fail("seek failed");
+        write(&count, sizeof(count));
+        int rc = std::fclose(file);
+        file = nullptr;
+        if (rc != 0) throw std::runtime_error("close failed");
+    }
+
+    uint64_t events() const { return count; }
+
+private:
+    std::FILE* file;
+    uint32_t symbol_count;
+    uint64_t count = 0;
+
+    void write(const void* p, size_t n) {
+        if (n && std::fwrite(p, 1, n, file) != n) fail("write failed");
+    }
+    [[noreturn]] void fail(const std::string& what) {
+        std::fclose(file);
+        file = nullptr;
+        throw std::runtime_error(what);
+    }
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "event_file.hpp"
+#include "order_message.hpp"
+#include "spsc_ring.hpp"
+#include "wait_strategy.hpp"
+
+// When a journaled message counts as persisted.
+enum class Durability {
+    NONE,    // write() only: survives a process crash, not an OS crash or power loss
+    ASYNC,   // write() + fdatasync() per group on the journal thread; matching does not wait
+    SYNC     // As ASYNC, and a batch is only matched once its group is on disk
+};
+
+inline const char* to_string(Durability d) {
+    switch (d) {
+        case Durability::NONE:  return "none";
+        case Durability::ASYNC: return "async";
+        default:                return "sync";
+    }
+}
+
+inline Durability parse_durability(std::string_view name) {
+    for (Durability d : {Durability::NONE, Durability::ASYNC, Durability::SYNC}) {
+        if (name == to_string(d)) return d;
+    }
+    throw std::invalid_argument("unknown durability: " + std::string(name));
+}
+
+struct JournalConfig {
+    std::string dir;                            // Empty: no journal
+    Durability durability = Durability::ASYNC;
+    size_t segment_bytes = size_t(64) << 20;    // Preallocated size of each segment file
+    bool recover = true;                        // Replay the existing journal into the books on start
+
+    // Throws std::invalid_argument if a segment cannot hold its header and one record.
+    void validate() const;
+    // Read LOB_JOURNAL_DIR, LOB_DURABILITY (none|async|sync) and LOB_JOURNAL_SEGMENT_MB.
+    // Throws std::invalid_argument on malformed values.
+    static JournalConfig from_env();
+};
+
+// A sequenced message as stored in a segment; a torn or never-written slot fails
+// the checksum or the sequence check.
+struct JournalRecord {
+    uint64_t sequence;
+    uint64_t checksum;          // FNV-1a of sequence and event
+    EventRecord event;
+    uint8_t reserved[8];
+};
+static_assert(sizeof(JournalRecord) == 64);
+
+struct JournalSegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t shard;
+    uint64_t first_sequence;    // Sequence of the segment's first record
+    uint8_t padding[32];
+};
+static_assert(sizeof(JournalSegmentHeader) == 64);
+
+struct JournalStats {
+    uint64_t records = 0;
+    uint64_t groups = 0;        // write() calls, each followed by one fdatasync() unless NONE
+    uint64_t bytes = 0;
+    uint64_t segments = 0;
+};
+
+// Write-ahead journal of one shard's sequenced input. The sequencing thread appends
+// accepted messages to a lock-free ring; a dedicated journal thread drains whatever
+// has accumulated into one buffer and group-commits it with a single write() and,
+// unless Durability::NONE, one fdatasync(). Segment files (<dir>/shard<k>-<first
+// sequence>.wal) are preallocated with fallocate, so commits never grow the file and
+// fdatasync has no size metadata to flush. A failed write or sync aborts the process:
+// the journal cannot tell the matcher to undo what it has already matched.
+class Journal {
+public:
+    // Deletes the shard's segments that start at or after `next_sequence`, opens a new
+    // segment whose first record will be `next_sequence` and starts the journal thread.
+    // Throws std::runtime_error if a segment cannot be removed or created.
+    Journal(const JournalConfig& config, size_t shard, uint64_t next_sequence);
+    ~Journal() { close(); }
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Sequencing thread: add a message; waits (yielding) while the ring is full.
+    void append(uint64_t sequence, const OrderMessage& message) {
+        JournalRecord r;
+        r.sequence = sequence;
+        r.event = to_record(message);
+        r.checksum = checksum(r);
+        while (!ring.try_push(r)) std::this_thread::yield();
+    }
+    // Sequencing thread, after a batch of appends: wakes the journal thread and, with
+    // Durability::SYNC, returns once `sequence` is on disk.
+    void commit(uint64_t sequence);
+
+    // Write out everything appended, then stop the journal thread and close the segment.
+    void close();
+
+    // Highest sequence written (NONE) or synced (ASYNC, SYNC).
+    uint64_t durable() const { return durable_.load(std::memory_order_acquire); }
+    Durability durability() const { return config.durability; }
+    // Journal-thread counters; call while the journal is idle for exact values.
+    JournalStats stats() const;
+
+    // Feed every intact record of `shard`'s journal in `dir` with a sequence above
+    // `after` to apply(sequence, message), in sequence order. Stops at the first torn,
+    // unwritten or out-of-sequence record. Returns the last sequence applied, or
+    // `after` if there was none. Throws std::runtime_error on a foreign or corrupt
+    // segment header.
+    static uint64_t recover(const std::string& dir, size_t shard, uint64_t after,
+                            const std::function<void(uint64_t, const OrderMessage&)>& apply);
+
+    // Delete the segments of `shard` in `dir` that hold nothing above `sequence`; the
+    // newest segment is always kept.
+    static void prune(const std::string& dir, size_t shard, uint64_t sequence);
+
+    static uint64_t checksum(const JournalRecord& r) {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&](const void* p, size_t n) {
+            for (size_t i = 0; i < n; ++i) h = (h ^ static_cast<const unsigned char*>(p)[i]) * 1099511628211ull;
+        };
+        mix(&r.sequence, sizeof(r.sequence));
+        mix(&r.event, sizeof(r.event));
+        return h;
+    }
+
+private:
+    static constexpr size_t RING_CAPACITY = 1 << 14;
+    static constexpr size_t GROUP_RECORDS = 1 << 14;   // 1 MB per write() at most
+
+    JournalConfig config;
+    size_t shard;
+    int fd = -1;
+    int dir_fd = -1;
+    uint64_t offset = 0;                               // Write position in the segment
+    std::vector<JournalRecord> group;
+    SpscRing<JournalRecord, RING_CAPACITY> ring;
+    IdleWaiter waiter{WaitStrategy::SPIN_PARK, 100};
+    std::atomic<bool> stopping{false};
+    alignas(CACHE_LINE) std::atomic<uint64_t> durable_{0};
+    std::atomic<uint64_t> records{0}, groups{0}, bytes{0}, segments{0};
+    std::thread writer;
+
+    void run();
+    void write_group(size_t n);
+    void open_segment(uint64_t first_sequence);
+    void close_segment();
+    void sync(int file);
+};
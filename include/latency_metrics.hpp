@@ -1,38 +1,239 @@
 #pragma once
-#include <vector>
-#include <mutex>
 #include <algorithm>
-#include <numeric>
-#include <deque>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
+// Percentiles of one LatencyMetrics window, in microseconds.
+struct LatencySummary {
+    uint64_t count = 0;
+    double mean = 0, min = 0, p50 = 0, p90 = 0, p99 = 0, p999 = 0, p9999 = 0, max = 0;
+};
+
+// Latency recorder for hot paths. Every recording thread owns its own log-bucketed
+// (HDR-style) histograms and updates them with relaxed atomic stores, so add() never
+// locks, allocates (after a thread's first call) or shares a cache line with another
+// writer. Readers merge the per-thread histograms, so a summary costs O(buckets)
+// no matter how many samples were recorded.
+//
+// Values are kept in nanoseconds: exact below 2^SUB_BITS ns, then 2^SUB_BITS buckets per
+// power of two (about 3% relative error), up to 2^MAX_BITS ns (~69 s), above which
+// they are clamped. The window is made of `slices` time slices; each recorder reuses
+// the slice of an expired period, so reads cover the last `window`, give or take one slice.
+// A recorder whose thread has exited keeps its samples and is handed to the next thread
+// that starts recording, so recorders never outnumber the threads recording at once.
 class LatencyMetrics {
-    std::deque<double> samples;
-    size_t max_samples;
-    std::mutex mtx;
 public:
-    LatencyMetrics(size_t max_samples_ = 1000) : max_samples(max_samples_) {}
-    void add(double v) {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (samples.size() >= max_samples) samples.pop_front();
-        samples.push_back(v);
-    }
-    std::vector<double> get_samples() {
-        std::lock_guard<std::mutex> lock(mtx);
-        return std::vector<double>(samples.begin(), samples.end());
-    }
-    double avg() {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (samples.empty()) return 0.0;
-        return std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
-    }
-    double min() {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (samples.empty()) return 0.0;
-        return *std::min_element(samples.begin(), samples.end());
-    }
-    double max() {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (samples.empty()) return 0.0;
-        return *std::max_element(samples.begin(), samples.end());
+    static constexpr int SUB_BITS = 5;
+    static constexpr int MAX_BITS = 36;
+    static constexpr uint64_t SUB_COUNT = uint64_t(1) << SUB_BITS;
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+    explicit LatencyMetrics(std::chrono::nanoseconds window = std::chrono::seconds(10), size_t slices = 10)
+        : slice_ns(std::max<int64_t>(1, window.count() / std::max<size_t>(1, slices))),
+          slice_count(std::max<size_t>(1, slices)),
+          instance(next_instance.fetch_add(1, std::memory_order_relaxed)) {}
+
+    LatencyMetrics(const LatencyMetrics&) = delete;
+    LatencyMetrics& operator=(const LatencyMetrics&) = delete;
+
+    // Record `count` samples of `micros` microseconds.
+    void add(double micros, uint64_t count = 1) {
+        uint64_t ns = micros <= 0 ? 0 : uint64_t(micros * 1000.0 + 0.5);
+        uint64_t epoch = now_ns() / slice_ns;
+        Slice& s = local().slices[epoch % slice_count];
+        if (s.epoch.load(std::memory_order_relaxed) != epoch) s.reset(epoch);
+        s.record(ns, count);
+    }
+
+    LatencySummary summary() const {
+        Histogram h;
+        uint64_t now = now_ns() / slice_ns;
+        merge(h, now + 1 - std::min<uint64_t>(now + 1, slice_count), now);
+        return h.summary();
+    }
+
+    // Percentile q (0..1) of every slice in the window, oldest first; 0 for empty slices.
+    std::vector<double> history(double q) const {
+        std::vector<double> out;
+        uint64_t now = now_ns() / slice_ns;
+        for (uint64_t e = now + 1 - std::min<uint64_t>(now + 1, slice_count); e <= now; ++e) {
+            Histogram h;
+            merge(h, e, e);
+            out.push_back(h.count ? h.percentile(q) : 0.0);
+        }
+        return out;
+    }
+
+    // Recorders allocated so far.
+    size_t recorder_count() const {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        return pool->recorders.size();
+    }
+
+    // Bucket of a value in ns, and the largest value that maps to a bucket.
+    static size_t bucket_of(uint64_t ns) {
+        ns = std::min(ns, (uint64_t(1) << MAX_BITS) - 1);
+        if (ns < SUB_COUNT) return ns;
+        int msb = 63 - std::countl_zero(ns);
+        uint64_t top = ns >> (msb - SUB_BITS);   // in [SUB_COUNT, 2 * SUB_COUNT)
+        return (msb - SUB_BITS + 1) * SUB_COUNT + (top - SUB_COUNT);
+    }
+    static uint64_t bucket_high(size_t bucket) {
+        if (bucket < SUB_COUNT) return bucket;
+        uint64_t shift = bucket / SUB_COUNT - 1;
+        uint64_t top = SUB_COUNT + bucket % SUB_COUNT;
+        return ((top + 1) << shift) - 1;
+    }
+
+private:
+    // One time slice of one thread's histogram. Only the owning thread writes it.
+    struct alignas(64) Slice {
+        std::atomic<uint64_t> epoch{UINT64_MAX};   // Slice period this data belongs to
+        std::atomic<uint64_t> count{0}, sum_ns{0}, min_ns{UINT64_MAX}, max_ns{0};
+        std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+
+        void reset(uint64_t new_epoch) {
+            epoch.store(UINT64_MAX, std::memory_order_relaxed);   // readers skip it while cleared
+            for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+            count.store(0, std::memory_order_relaxed);
+            sum_ns.store(0, std::memory_order_relaxed);
+            min_ns.store(UINT64_MAX, std::memory_order_relaxed);
+            max_ns.store(0, std::memory_order_relaxed);
+            epoch.store(new_epoch, std::memory_order_release);
+        }
+        void record(uint64_t ns, uint64_t n) {
+            auto& b = buckets[bucket_of(ns)];
+            b.store(b.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            sum_ns.store(sum_ns.load(std::memory_order_relaxed) + ns * n, std::memory_order_relaxed);
+            if (ns < min_ns.load(std::memory_order_relaxed)) min_ns.store(ns, std::memory_order_relaxed);
+            if (ns > max_ns.load(std::memory_order_relaxed)) max_ns.store(ns, std::memory_order_relaxed);
+        }
+    };
+
+    struct Recorder {
+        std::unique_ptr<Slice[]> slices;
+        explicit Recorder(size_t n) : slices(new Slice[n]) {}
+    };
+
+    // Recorders of one metrics object. Shared with the thread caches, so a thread that
+    // exits can return its recorder while the metrics still live.
+    struct Pool {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Recorder>> recorders;  // Every recorder, in use or free
+        std::vector<Recorder*> free;                        // Of exited threads, taken by the next
+    };
+
+    struct CacheEntry {
+        uint64_t instance;
+        Recorder* recorder;
+        std::weak_ptr<Pool> pool;
+    };
+    // A thread's recorders, one per metrics object it records into; returned on thread exit.
+    // The pool's mutex orders the old owner's stores before the next owner's.
+    struct ThreadCache {
+        std::vector<CacheEntry> entries;
+        ~ThreadCache() {
+            for (const CacheEntry& e : entries) {
+                if (auto pool = e.pool.lock()) {
+                    std::lock_guard<std::mutex> lock(pool->mutex);
+                    pool->free.push_back(e.recorder);
+                }
+            }
+        }
+    };
+
+    // Merged (non-atomic) histogram built by readers.
+    struct Histogram {
+        std::array<uint64_t, BUCKETS> buckets{};
+        uint64_t count = 0, sum_ns = 0, min_ns = UINT64_MAX, max_ns = 0;
+
+        double percentile(double q) const {
+            uint64_t rank = std::max<uint64_t>(1, uint64_t(q * count + 0.5));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                seen += buckets[i];
+                if (seen >= rank) return std::clamp(bucket_high(i), min_ns, max_ns) / 1000.0;
+            }
+            return max_ns / 1000.0;
+        }
+        LatencySummary summary() const {
+            LatencySummary s;
+            if (!count) return s;
+            s.count = count;
+            s.mean = double(sum_ns) / count / 1000.0;
+            s.min = min_ns / 1000.0;
+            s.p50 = percentile(0.5);
+            s.p90 = percentile(0.9);
+            s.p99 = percentile(0.99);
+            s.p999 = percentile(0.999);
+            s.p9999 = percentile(0.9999);
+            s.max = max_ns / 1000.0;
+            return s;
+        }
+    };
+
+    inline static std::atomic<uint64_t> next_instance{0};
+    const uint64_t slice_ns;
+    const size_t slice_count;
+    const uint64_t instance;                          // Keys the per-thread recorder cache
+    const std::shared_ptr<Pool> pool = std::make_shared<Pool>();
+
+    // Slices are far longer than a scheduler tick, so the cheap coarse clock is enough
+    static uint64_t now_ns() {
+#ifdef CLOCK_MONOTONIC_COARSE
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Recorder of the calling thread, taken on its first add(): a returned one if any,
+    // else a new one. Entries of metrics destroyed since are dropped from the cache here.
+    Recorder& local() {
+        thread_local ThreadCache cache;
+        for (const CacheEntry& e : cache.entries) {
+            if (e.instance == instance) return *e.recorder;
+        }
+        std::erase_if(cache.entries, [](const CacheEntry& e) { return e.pool.expired(); });
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        Recorder* r;
+        if (!pool->free.empty()) {
+            r = pool->free.back();
+            pool->free.pop_back();
+        } else {
+            pool->recorders.push_back(std::make_unique<Recorder>(slice_count));
+            r = pool->recorders.back().get();
+        }
+        cache.entries.push_back({instance, r, pool});
+        return *r;
+    }
+
+    // Add every thread's slices for epochs first..last into h.
+    void merge(Histogram& h, uint64_t first, uint64_t last) const {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        for (auto& r : pool->recorders) {
+            for (size_t i = 0; i < slice_count; ++i) {
+                const Slice& s = r->slices[i];
+                uint64_t epoch = s.epoch.load(std::memory_order_acquire);
+                if (epoch == UINT64_MAX || epoch < first || epoch > last) continue;
+                for (size_t b = 0; b < BUCKETS; ++b) h.buckets[b] += s.buckets[b].load(std::memory_order_relaxed);
+                h.count += s.count.load(std::memory_order_relaxed);
+                h.sum_ns += s.sum_ns.load(std::memory_order_relaxed);
+                h.min_ns = std::min(h.min_ns, s.min_ns.load(std::memory_order_relaxed));
+                h.max_ns = std::max(h.max_ns, s.max_ns.load(std::memory_order_relaxed));
+            }
+        }
     }
 };
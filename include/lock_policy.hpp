@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Pause hint for spin-wait loops.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// Lock policies for BasicOrderBook. Any type with lock()/unlock() works
+// (std::mutex included); the book never locks recursively.
+
+// No locking: for a book owned by a single thread (e.g. the matcher).
+struct NullLock {
+    void lock() {}
+    bool try_lock() { return true; }
+    void unlock() {}
+};
+
+// Test-and-test-and-set spin lock for short critical sections with little contention.
+// Spins with a pause hint, then yields so it stays usable when threads outnumber cores.
+class SpinLock {
+    std::atomic<bool> locked{false};
+
+public:
+    void lock() {
+        for (int spins = 0; locked.exchange(true, std::memory_order_acquire); ) {
+            while (locked.load(std::memory_order_relaxed)) {
+                if (++spins < 64) cpu_relax(); else std::this_thread::yield();
+            }
+        }
+    }
+    bool try_lock() {
+        return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+    }
+    void unlock() { locked.store(false, std::memory_order_release); }
+};
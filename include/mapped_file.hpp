@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file. The kernel pages the file in as it is
+// read (sequential access is advised), so replaying a file costs no read() copies
+// and no heap. Throws std::runtime_error if the file cannot be opened or mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) fail("open", path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            fail("stat", path);
+        }
+        length = size_t(st.st_size);
+        if (length > 0) {
+            void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                fail("mmap", path);
+            }
+            base = static_cast<const char*>(p);
+            ::madvise(p, length, MADV_SEQUENTIAL);
+        }
+        ::close(fd);   // The mapping keeps the file alive
+    }
+    ~MappedFile() {
+        if (base) ::munmap(const_cast<char*>(base), length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return base; }
+    const char* end() const { return base + length; }
+    size_t size() const { return length; }
+
+private:
+    const char* base = nullptr;
+    size_t length = 0;
+
+    [[noreturn]] static void fail(const char* what, const std::string& path) {
+        throw std::runtime_error(std::string("cannot ") + what + " " + path + ": " + std::strerror(errno));
+    }
+};
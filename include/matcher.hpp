@@ -1,8 +1,62 @@
 #pragma once
+#include <mutex>
+#include <span>
 #include "order.hpp"
 #include "order_book.hpp"
+#include "trade_tape.hpp"
 
+// Matches incoming orders against a book. Instantiated for the NullLock, SpinLock
+// and std::mutex books.
 class Matcher {
 public:
-    void match_order(Order& incoming_order, OrderBook& book);
+    // Fills are logged and, if `tape` is set, appended to it with their match latency.
+    // The tape must only be appended to by the thread using this matcher.
+    explicit Matcher(TradeTape* tape = nullptr) : tape(tape) {}
+
+    template <typename LockPolicy>
+    void match_order(Order& incoming_order, BasicOrderBook<LockPolicy>& book);
+
+    // Match without logging or taping: each fill goes to on_fill(maker_id, price, qty)
+    // and the caller decides what to record (the pipelined engine hands fills to its
+    // publish stage).
+    template <typename LockPolicy, typename OnFill>
+    static void match_order(Order& incoming_order, BasicOrderBook<LockPolicy>& book, OnFill&& on_fill) {
+        std::lock_guard<LockPolicy> lock(book.book_mutex);
+        execute(incoming_order, book, on_fill);
+    }
+
+    // Match a batch of incoming orders back to back under a single acquisition of the
+    // book lock. If `latency_ns` is non-empty, latency_ns[i] receives the match time of
+    // batch[i]; the clock is read once per order boundary.
+    template <typename LockPolicy>
+    void match_batch(std::span<Order> batch, BasicOrderBook<LockPolicy>& book, std::span<double> latency_ns = {});
+
+private:
+    TradeTape* tape;
+
+    // Match one order while the caller holds the book lock.
+    template <typename LockPolicy>
+    void match_unlocked(Order& incoming_order, BasicOrderBook<LockPolicy>& book);
+
+    // Take liquidity, then rest a LIMIT remainder or let crossed stops fire. A STOP or
+    // STOP_LIMIT that has not fired takes nothing: it joins the book's stop ladder. Book lock held.
+    template <typename LockPolicy, typename OnFill>
+    static void execute(Order& incoming, BasicOrderBook<LockPolicy>& book, OnFill& on_fill) {
+        bool stop = incoming.type == OrderType::STOP || incoming.type == OrderType::STOP_LIMIT;
+        if (stop && !incoming.triggered) {
+            book.add_unlocked(incoming);
+            return;
+        }
+        if (incoming.side == Side::BUY) {
+            book.template match_unlocked<Side::BUY>(incoming, on_fill);
+        } else {
+            book.template match_unlocked<Side::SELL>(incoming, on_fill);
+        }
+        if (incoming.filled < incoming.quantity && incoming.type == OrderType::LIMIT) {
+            book.add_unlocked(incoming);
+        } else {
+            // Fills moved the quotes or the last trade; let crossed stops fire
+            book.trigger_stops_unlocked();
+        }
+    }
 };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Untyped pool of equally sized blocks, used behind PoolAllocator for container nodes.
+// The block size is bound by the first single-object allocation, which is the
+// container's node type; every other request size goes to the global heap.
+class NodePool {
+    static constexpr size_t ALIGN = alignof(std::max_align_t);  // operator new[] already aligns to this
+
+    struct FreeBlock { FreeBlock* next; };
+
+    std::vector<std::unique_ptr<std::byte[]>> slabs;
+    FreeBlock* free_list = nullptr;
+    size_t block_size = 0;
+    size_t slab_blocks;
+
+    void grow() {
+        slabs.emplace_back(new std::byte[block_size * slab_blocks]);
+        std::byte* slab = slabs.back().get();
+        for (size_t i = 0; i < slab_blocks; ++i) {
+            auto* block = reinterpret_cast<FreeBlock*>(slab + i * block_size);
+            block->next = free_list;
+            free_list = block;
+        }
+    }
+
+public:
+    explicit NodePool(size_t blocks) : slab_blocks(blocks ? blocks : 1) { slabs.reserve(16); }
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    // True if a block of `bytes` is served from the pool. Binds the block size on first use.
+    bool accepts(size_t bytes) {
+        if (block_size == 0) {
+            block_size = (std::max(bytes, sizeof(FreeBlock)) + ALIGN - 1) / ALIGN * ALIGN;
+            grow();
+        }
+        return bytes <= block_size && bytes * 2 > block_size;
+    }
+
+    void* allocate() {
+        if (!free_list) grow();
+        FreeBlock* block = free_list;
+        free_list = block->next;
+        return block;
+    }
+
+    void deallocate(void* p) {
+        auto* block = static_cast<FreeBlock*>(p);
+        block->next = free_list;
+        free_list = block;
+    }
+};
+
+// STL allocator that serves single-node allocations from a NodePool.
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+    NodePool* pool;
+
+    explicit PoolAllocator(NodePool* p) noexcept : pool(p) {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool(other.pool) {}
+
+    T* allocate(size_t n) {
+        if (n == 1 && alignof(T) <= alignof(std::max_align_t) && pool->accepts(sizeof(T)))
+            return static_cast<T*>(pool->allocate());
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (n == 1 && alignof(T) <= alignof(std::max_align_t) && pool->accepts(sizeof(T)))
+            pool->deallocate(p);
+        else
+            ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept { return pool == other.pool; }
+};
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include "price.hpp"
 
 enum class Side { BUY, SELL };
 // OrderType now supports LIMIT, MARKET, STOP, and STOP_LIMIT orders
@@ -12,14 +14,15 @@ enum class OrderStatus { OPEN, PARTIALLY_FILLED, FILLED, CANCELED };
 // It now supports stop and stop-limit orders with the stop_price field.
 struct Order {
     int order_id;                // Unique order identifier
+    uint32_t symbol_id = 0;      // Instrument; selects the book inside an Engine
     long long timestamp;         // Time the order was created
     Side side;                   // BUY or SELL
     OrderType type;              // LIMIT, MARKET, STOP, or STOP_LIMIT
-    double price;                // Limit price (for LIMIT/STOP_LIMIT orders)
+    Price price;                 // Limit price in ticks (for LIMIT/STOP_LIMIT orders)
     int quantity;                // Total quantity requested
     int filled = 0;              // Quantity already filled
     OrderStatus status;          // Current status of the order
-    double stop_price = 0.0;     // Stop price (for STOP/STOP_LIMIT orders)
+    Price stop_price;            // Stop price in ticks (for STOP/STOP_LIMIT orders)
     bool triggered = false;      // True if stop order has been triggered
 
     // Constructor for LIMIT and MARKET orders
@@ -28,7 +31,7 @@ struct Order {
         long long ts,
         Side s,
         OrderType t,
-        double p,
+        Price p,
         int qty
     ) : order_id(id), timestamp(ts), side(s), type(t), price(p), quantity(qty), status(OrderStatus::OPEN) {}
 
@@ -38,8 +41,8 @@ struct Order {
         long long ts,
         Side s,
         OrderType t,
-        double p,
+        Price p,
         int qty,
-        double stop_p
+        Price stop_p
     ) : order_id(id), timestamp(ts), side(s), type(t), price(p), quantity(qty), status(OrderStatus::OPEN), stop_price(stop_p), triggered(false) {}
 };
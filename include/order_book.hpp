@@ -1,24 +1,255 @@
 #pragma once
 
-#include <map>
-#include <queue>
+#include <algorithm>
+#include <limits>
 #include <mutex>
+#include <vector>
 #include "order.hpp"
-#include <unordered_map>
+#include "order_store.hpp"
+#include "order_list.hpp"
+#include "price_ladder.hpp"
+#include "order_index.hpp"
+#include "lock_policy.hpp"
 
-class OrderBook {
+// Which prices can trigger pending stop orders.
+enum class StopTriggerPolicy {
+    QUOTES,             // best ask for buy stops, best bid for sell stops
+    TRADES,             // last trade price
+    QUOTES_AND_TRADES   // either of the above
+};
+
+// Startup sizing of a book. Order records, price levels and the order index are
+// preallocated for these counts so the steady-state add/cancel/match path
+// never calls operator new.
+struct BookConfig {
+    double tick_size = DEFAULT_TICK_SIZE;   // Tick size of the instrument
+    size_t max_orders = 1 << 16;            // Resting orders preallocated
+    size_t max_levels = 1 << 14;            // Price levels per side preallocated
+    size_t max_ladder_ticks = 1 << 20;      // Array ladder: widest price window; farther levels go to an overflow map
+    StopTriggerPolicy stop_policy = StopTriggerPolicy::QUOTES;
+    IndexMode index_mode = IndexMode::HASH; // DIRECT when ids are dense and below max_orders
+};
+
+// Aggregated view of one price level, as returned by OrderBook::depth.
+struct DepthLevel {
+    Price price;
+    int64_t quantity;            // Total open quantity at the level
+    int orders;                  // Number of resting orders at the level
+};
+
+// A pending stop or stop-limit order as shown in a BookSnapshot.
+struct PendingStop {
+    int order_id;
+    Side side;
+    OrderType type;              // STOP or STOP_LIMIT
+    int quantity;
+    Price stop_price;
+    Price limit_price;           // Limit price of a STOP_LIMIT order
+};
+
+// Fixed-size, self-contained copy of the top of the book, published by the matching
+// thread (see Seqlock) so that readers such as the GUI never touch the book itself.
+struct BookSnapshot {
+    static constexpr size_t LEVELS = 20;   // Aggregated levels per side
+    static constexpr size_t STOPS = 50;    // Pending stops listed
+
+    double tick_size;
+    Price best_bid, best_ask;    // NO_PRICE if that side is empty
+    Price last_trade;            // NO_PRICE before the first trade
+    size_t bid_levels, ask_levels, stop_count;
+    DepthLevel bids[LEVELS];     // Best first
+    DepthLevel asks[LEVELS];
+    PendingStop stops[STOPS];    // Buy stops lowest first, then sell stops highest first
+};
+
+class Matcher;
+
+// Limit order book. Every public method takes `book_mutex` (a LockPolicy: NullLock,
+// SpinLock or std::mutex) exactly once; internally nothing re-locks, and stops that
+// fire are run from a work list rather than by recursing into add_order.
+template <typename LockPolicy>
+class BasicOrderBook {
 public:
-    std::map<double, std::queue<Order>, std::greater<>> buy_book;
-    std::map<double, std::queue<Order>> sell_book;
-    std::unordered_map<int, std::pair<double, Side>> order_index;
-    std::recursive_mutex book_mutex;
+    // Hot/cold storage of every resting order; levels and the index refer to it by handle
+    OrderStore orders;
+
+    // Price levels per side; the backend (map or array ladder) is chosen at build time.
+    // Each level is an intrusive FIFO of the orders resting at that price.
+    PriceLadder<Side::BUY, OrderList> buy_book;
+    PriceLadder<Side::SELL, OrderList> sell_book;
+    OrderIndex order_index;      // Order id -> handle of the resting or pending stop order
+    double tick_size;            // Tick size of the instrument traded in this book
+    LockPolicy book_mutex;
 
-    // Store pending stop and stop-limit orders until triggered
-    std::vector<Order> stop_orders;
+    // Pending stop and stop-limit orders keyed by stop price, in firing order:
+    // buy stops fire lowest stop first (ascending), sell stops highest first (descending).
+    // Orders at the same stop price queue in time priority.
+    PriceLadder<Side::SELL, OrderList> buy_stops;
+    PriceLadder<Side::BUY, OrderList> sell_stops;
+    StopTriggerPolicy stop_policy;
+
+    explicit BasicOrderBook(const BookConfig& config = BookConfig());
+    ~BasicOrderBook();
+    BasicOrderBook(const BasicOrderBook&) = delete;
+    BasicOrderBook& operator=(const BasicOrderBook&) = delete;
 
     // Add an order to the book. Handles LIMIT, MARKET, STOP, and STOP_LIMIT orders.
     void add_order(const Order& order);
     void cancel_order(int order_id);
-    void modify_order(int order_id, double new_price, int new_qty);
+    // new_qty is the order's total size; one at or below the filled quantity cancels it.
+    void modify_order(int order_id, Price new_price, int new_qty);
     void print_top_levels(int depth = 5);
+
+    // Top `n` levels of one side, best first, read from the per-level aggregates.
+    std::vector<DepthLevel> depth(Side side, size_t n);
+    // Allocation-free variant: fills `out` with up to `n` levels and returns the count.
+    size_t depth(Side side, DepthLevel* out, size_t n);
+
+    // Quantity a taker on `taker_side` could fill at `limit` or better
+    // (e.g. for fill-or-kill checks or market-impact estimates).
+    int64_t available_liquidity(Side taker_side, Price limit);
+
+    // Pending stop and stop-limit orders, lowest stop first for buys then highest first for sells.
+    std::vector<Order> pending_stops(size_t max_orders = SIZE_MAX);
+
+    // Visit every resting order (bids best first, then asks, each level in queue order)
+    // and then every pending stop, as f(const Order&, uint64_t arrival). `arrival` is the
+    // order's arrival sequence in this book. Allocation-free; used to write snapshots.
+    template <typename F>
+    void for_each_order(F&& f);
+
+    // Put back an order captured by for_each_order, without matching it or checking
+    // stops: a resting order joins the back of its level, a pending stop its stop level.
+    // Restore resting orders in visit order and pending stops by arrival, into an empty
+    // book, then call restore_last_trade.
+    void restore_order(const Order& order);
+    // Last trade print of a restored book; its current quotes count as already checked.
+    void restore_last_trade(Price price);
+    Price last_trade_price() const { return last_trade; }
+
+    // Fill `out` with the current L1/L2 view and pending stops. Allocation-free; meant
+    // to be called by the thread that owns the book and then published.
+    void snapshot(BookSnapshot& out);
+
+    // Match `taker` against the opposite side of the book, best price first, while the
+    // level price is within the taker's limit (MARKET orders have none). Executed
+    // quantity is added to taker.filled and `on_fill(maker_id, price, qty)` runs after
+    // each execution. The opposite ladder and the price comparison are chosen at
+    // compile time from S, so the inner loop has no side or order-type branches.
+    // Returns the executed quantity; the unfilled remainder is left to the caller.
+    template <Side S, typename OnFill>
+    int match(Order& taker, OnFill&& on_fill) {
+        std::lock_guard<LockPolicy> lock(book_mutex);
+        return match_unlocked<S>(taker, on_fill);
+    }
+
+    // Drop an order that has already been unlinked from its level (e.g. fully filled).
+    void release_order(OrderHandle h);
+    // Cancel a resting or pending stop order by handle. Book lock held.
+    void cancel_unlocked(OrderHandle h, int order_id);
+
+    // Record a trade print (used by the TRADES stop trigger policies).
+    void record_trade(Price price) { last_trade = price; }
+
+    // Fire stops crossed by the current quotes / last trade. Does nothing unless one
+    // of the reference prices moved since the previous check.
+    void trigger_stops();
+
+private:
+    // The matcher holds the lock once per batch and uses the unlocked operations
+    friend class Matcher;
+
+    Price last_trade = NO_PRICE;
+    // Reference prices seen by the previous stop check
+    Price checked_bid = NO_PRICE, checked_ask = NO_PRICE, checked_trade = NO_PRICE;
+    std::vector<OrderHandle> fired;      // Scratch list of crossed stop handles
+    std::vector<Order> activated;        // Triggered stops waiting to run, in firing order
+    size_t next_activated = 0;
+
+    // Unlocked bodies of the public operations; the caller holds book_mutex.
+    void add_unlocked(const Order& order);
+    void trigger_stops_unlocked();
+    size_t depth_unlocked(Side side, DepthLevel* out, size_t n);
+    template <Side S, typename OnFill>
+    int match_unlocked(Order& taker, OnFill&& on_fill);
+
+    // Place one order without running the stops it triggers.
+    void enter(const Order& order);
+    // Unlink a resting order from its level, erasing the level if it empties.
+    void unlink_order(OrderHandle h);
+    // Unlink a pending stop from its stop level, erasing the level if it empties.
+    void unlink_stop(OrderHandle h);
+    bool is_pending_stop(OrderHandle h) const;
+    // Queue stops crossed by the reference prices if any of them moved since the last check.
+    void check_stops();
+    // Queue every stop crossed by the current reference prices, in time priority.
+    void collect_stops();
+    // Run queued stops until none are left; stops they trigger are appended and run too.
+    void run_stops();
 };
+
+// Book shared between threads; the matcher's own book uses NullLock.
+using OrderBook = BasicOrderBook<std::mutex>;
+
+template <typename LockPolicy>
+template <typename F>
+void BasicOrderBook<LockPolicy>::for_each_order(F&& f) {
+    std::lock_guard<LockPolicy> lock(book_mutex);
+    auto visit = [&](Price, const OrderList& level) {
+        for (OrderHandle h = level.front(); h != NULL_HANDLE; h = orders[h].next) f(orders.to_order(h), orders.cold(h).sequence);
+        return true;
+    };
+    buy_book.for_each_level(visit);
+    sell_book.for_each_level(visit);
+    buy_stops.for_each_level(visit);
+    sell_stops.for_each_level(visit);
+}
+
+template <typename LockPolicy>
+template <Side S, typename OnFill>
+int BasicOrderBook<LockPolicy>::match_unlocked(Order& taker, OnFill&& on_fill) {
+    auto& opposite = [this]() -> auto& {
+        if constexpr (S == Side::BUY) return sell_book; else return buy_book;
+    }();
+    // A MARKET order's limit is the far end of the price range
+    Price limit = taker.price;
+    if (taker.type == OrderType::MARKET) {
+        limit = S == Side::BUY ? Price(std::numeric_limits<int64_t>::max()) : NO_PRICE;
+    }
+
+    int remaining = taker.quantity - taker.filled;
+    int executed = 0;
+    while (remaining > 0 && !opposite.empty()) {
+        Price level_price = opposite.best_price();
+        if constexpr (S == Side::BUY) {
+            if (level_price > limit) break;
+        } else {
+            if (level_price < limit) break;
+        }
+        OrderList& level = opposite.best();
+        while (remaining > 0 && !level.empty()) {
+            OrderHandle top = level.front();
+            OrderNode& resting = orders[top];
+            int qty = std::min(remaining, resting.quantity);
+            int maker_id = resting.order_id;
+            remaining -= qty;
+            executed += qty;
+            level.reduce(orders, top, qty);
+            orders.cold(top).filled += qty;
+            // A partially filled maker keeps its place at the front of the level
+            if (resting.quantity == 0) {
+                level.erase(orders, top);
+                release_order(top);
+            }
+            on_fill(maker_id, level_price, qty);
+        }
+        record_trade(level_price);
+        if (level.empty()) opposite.erase(level_price);
+    }
+
+    if (executed > 0) {
+        taker.filled += executed;
+        taker.status = remaining == 0 ? OrderStatus::FILLED : OrderStatus::PARTIALLY_FILLED;
+    }
+    return executed;
+}
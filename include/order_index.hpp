@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "order_store.hpp"
+
+// How the book maps order ids to handles.
+enum class IndexMode {
+    HASH,    // open-addressing hash table (any id distribution)
+    DIRECT   // vector indexed by id for dense, monotonic ids; other ids spill to the hash table
+};
+
+// Open-addressing hash table from order id to OrderHandle, with linear probing
+// and backward-shift deletion (no tombstones, so probe chains never degrade).
+// Slots are 8 bytes; an empty slot holds NULL_HANDLE. Sized at construction so the
+// expected number of orders fills at most 1/2 of the slots; doubles once an insert
+// would take the load factor above 0.7.
+class FlatOrderIndex {
+    struct Slot {
+        int key;
+        OrderHandle value;
+    };
+
+    std::vector<Slot> slots;
+    size_t mask = 0;
+    unsigned shift = 0;
+    size_t count = 0;
+
+    // Fibonacci hashing: monotonic ids spread evenly over the table
+    size_t home(int key) const { return (static_cast<uint32_t>(key) * 0x9E3779B9u) >> shift; }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old = std::move(slots);
+        slots.assign(capacity, Slot{0, NULL_HANDLE});
+        mask = capacity - 1;
+        shift = 32 - __builtin_ctzll(capacity);
+        count = 0;
+        for (const Slot& s : old) {
+            if (s.value != NULL_HANDLE) insert(s.key, s.value);
+        }
+    }
+
+public:
+    explicit FlatOrderIndex(size_t expected) {
+        size_t capacity = 2;
+        while (capacity < expected * 2) capacity *= 2;
+        rehash(capacity);
+    }
+
+    OrderHandle find(int key) const {
+        for (size_t i = home(key);; i = (i + 1) & mask) {
+            const Slot& s = slots[i];
+            if (s.value == NULL_HANDLE) return NULL_HANDLE;
+            if (s.key == key) return s.value;
+        }
+    }
+
+    // Insert or overwrite.
+    void insert(int key, OrderHandle value) {
+        if ((count + 1) * 10 > slots.size() * 7) rehash(slots.size() * 2);
+        for (size_t i = home(key);; i = (i + 1) & mask) {
+            Slot& s = slots[i];
+            if (s.value == NULL_HANDLE) {
+                s = Slot{key, value};
+                ++count;
+                return;
+            }
+            if (s.key == key) {
+                s.value = value;
+                return;
+            }
+        }
+    }
+
+    void erase(int key) {
+        size_t i = home(key);
+        for (;; i = (i + 1) & mask) {
+            if (slots[i].value == NULL_HANDLE) return;
+            if (slots[i].key == key) break;
+        }
+        // Shift later members of the probe chain back into the hole
+        for (size_t j = (i + 1) & mask; slots[j].value != NULL_HANDLE; j = (j + 1) & mask) {
+            size_t h = home(slots[j].key);
+            if (((j - h) & mask) >= ((j - i) & mask)) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i].value = NULL_HANDLE;
+        --count;
+    }
+
+    size_t size() const { return count; }
+};
+
+// Order id -> handle of a resting or pending stop order.
+// In DIRECT mode ids in [0, expected) are looked up in a plain vector; ids outside
+// that range still work through the hash table.
+class OrderIndex {
+    IndexMode mode;
+    std::vector<OrderHandle> direct;
+    size_t direct_count = 0;
+    FlatOrderIndex hashed;
+
+    bool is_direct(int id) const { return static_cast<size_t>(static_cast<unsigned>(id)) < direct.size(); }
+
+public:
+    OrderIndex(IndexMode mode_, size_t expected)
+        : mode(mode_),
+          direct(mode_ == IndexMode::DIRECT ? expected : 0, NULL_HANDLE),
+          hashed(mode_ == IndexMode::DIRECT ? 1024 : expected) {}
+
+    // Handle for `id`, or NULL_HANDLE if unknown.
+    OrderHandle find(int id) const {
+        if (mode == IndexMode::DIRECT && is_direct(id)) return direct[id];
+        return hashed.find(id);
+    }
+
+    bool contains(int id) const { return find(id) != NULL_HANDLE; }
+
+    void insert(int id, OrderHandle h) {
+        if (mode == IndexMode::DIRECT && is_direct(id)) {
+            if (direct[id] == NULL_HANDLE) ++direct_count;
+            direct[id] = h;
+        } else {
+            hashed.insert(id, h);
+        }
+    }
+
+    void erase(int id) {
+        if (mode == IndexMode::DIRECT && is_direct(id)) {
+            if (direct[id] != NULL_HANDLE) --direct_count;
+            direct[id] = NULL_HANDLE;
+        } else {
+            hashed.erase(id);
+        }
+    }
+
+    size_t size() const { return direct_count + hashed.size(); }
+};
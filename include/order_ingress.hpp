@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "order.hpp"
+#include "order_message.hpp"
+#include "spsc_ring.hpp"
+
+// What push() does when the producer's lane is at capacity.
+enum class OverflowPolicy {
+    BLOCK,                    // Wait (yielding) until the consumer frees a slot
+    REJECT,                   // Refuse the message and count it
+    DROP_OLDEST_NON_CANCEL,   // Accept it; the consumer discards the lane's oldest queued non-cancel
+};
+
+enum class PushResult { ACCEPTED, REJECTED };
+
+inline const char* to_string(OverflowPolicy policy) {
+    switch (policy) {
+        case OverflowPolicy::BLOCK:  return "block";
+        case OverflowPolicy::REJECT: return "reject";
+        default:                     return "drop_oldest_non_cancel";
+    }
+}
+
+inline OverflowPolicy parse_overflow_policy(std::string_view name) {
+    for (OverflowPolicy p : {OverflowPolicy::BLOCK, OverflowPolicy::REJECT, OverflowPolicy::DROP_OLDEST_NON_CANCEL}) {
+        if (name == to_string(p)) return p;
+    }
+    throw std::invalid_argument("unknown overflow policy: " + std::string(name));
+}
+
+// Physical slots per producer lane.
+constexpr size_t INGRESS_LANE_CAPACITY = 1 << 12;
+
+struct IngressConfig {
+    size_t capacity = 2048;        // Non-cancel messages queued per lane
+    size_t cancel_reserve = 256;   // Further slots per lane that only cancels may use
+    OverflowPolicy overflow = OverflowPolicy::BLOCK;
+
+    // Throws std::invalid_argument unless 0 < capacity and capacity + cancel_reserve <= INGRESS_LANE_CAPACITY.
+    void validate() const {
+        if (capacity == 0 || capacity + cancel_reserve > INGRESS_LANE_CAPACITY)
+            throw std::invalid_argument("ingress capacity + cancel_reserve must be in 1.." + std::to_string(INGRESS_LANE_CAPACITY));
+    }
+
+    // Read LOB_INGRESS_CAPACITY, LOB_CANCEL_RESERVE and LOB_OVERFLOW
+    // (block|reject|drop_oldest_non_cancel). Throws std::invalid_argument on malformed values.
+    static IngressConfig from_env() {
+        IngressConfig config;
+        auto number = [](const char* name, const char* v) {
+            size_t used = 0;
+            unsigned long n = 0;
+            try { n = std::stoul(v, &used); } catch (const std::exception&) {}
+            if (used == 0 || v[used] != '\0') throw std::invalid_argument(std::string("bad ") + name + ": " + v);
+            return size_t(n);
+        };
+        if (const char* v = std::getenv("LOB_INGRESS_CAPACITY")) config.capacity = number("LOB_INGRESS_CAPACITY", v);
+        if (const char* v = std::getenv("LOB_CANCEL_RESERVE")) config.cancel_reserve = number("LOB_CANCEL_RESERVE", v);
+        if (const char* v = std::getenv("LOB_OVERFLOW")) config.overflow = parse_overflow_policy(v);
+        config.validate();
+        return config;
+    }
+};
+
+// Counters summed over all lanes; readable from any thread.
+struct IngressStats {
+    uint64_t depth = 0;       // Messages queued now (displaced ones excluded)
+    uint64_t max_depth = 0;   // Highest depth any lane has reached
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;    // Refused by push() (REJECT, or a lane physically full)
+    uint64_t shed = 0;        // Discarded by DROP_OLDEST_NON_CANCEL
+};
+
+// Multi-producer/single-consumer ingress built from one SPSC lane per producer.
+// Producers never contend with each other: each registers once and then only writes
+// its own lane. The consumer merges the lanes round-robin, taking at most one message
+// from a lane before moving to the next: each producer's messages are matched in the
+// order it pushed them and every producer gets an equal share of the matcher. The
+// interleaving across lanes depends on what each producer has published by the time
+// the consumer reaches its lane, so it is not reproducible from run to run.
+//
+// Each lane is bounded at `capacity` messages, plus `cancel_reserve` slots only
+// cancels may take, so a flood of new orders cannot hold back the cancels behind it.
+// DROP_OLDEST_NON_CANCEL never touches the consumer's end of the ring: the producer
+// records a shed request and the consumer discards the oldest queued non-cancel when
+// it next reaches the lane. Displaced messages hold their slot until then, so that
+// policy needs capacity + cancel_reserve < LANE_CAPACITY; if the slack is used up the
+// message is rejected.
+template <typename Message>
+class BasicOrderIngress {
+public:
+    static constexpr size_t LANE_CAPACITY = INGRESS_LANE_CAPACITY;
+    using Ring = SpscRing<Message, LANE_CAPACITY>;
+
+    // All lanes are allocated up front (LANE_CAPACITY messages each).
+    explicit BasicOrderIngress(size_t max_producers, const IngressConfig& config = {})
+        : config(config), lanes(max_producers) {
+        config.validate();
+        for (auto& lane : lanes) lane = std::make_unique<Lane>();
+    }
+
+    // Claim a lane for the calling producer. Call once per producer thread.
+    size_t register_producer() {
+        size_t id = registered.fetch_add(1, std::memory_order_acq_rel);
+        if (id >= lanes.size()) throw std::runtime_error("OrderIngress: too many producers");
+        return id;
+    }
+
+    // Producer: enqueue on `lane` if it has room (or, with DROP_OLDEST_NON_CANCEL,
+    // displace an older message). Returns false if full; never waits or counts.
+    bool try_push(size_t lane, const Message& message) {
+        Lane& l = *lanes[lane];
+        bool cancel = is_cancel(message);
+        size_t depth = l.ring.size();
+        uint64_t requested = l.shed_requested.load(std::memory_order_relaxed);
+        size_t live = depth - (requested - l.shed_done.load(std::memory_order_acquire));
+        bool displace = false;
+        if (live >= config.capacity + (cancel ? config.cancel_reserve : 0)) {
+            if (cancel || config.overflow != OverflowPolicy::DROP_OLDEST_NON_CANCEL) return false;
+            if (depth >= LANE_CAPACITY - config.cancel_reserve) return false;
+            displace = true;
+        }
+        if (!l.ring.try_push(message)) return false;
+        if (displace) {
+            l.shed_requested.store(requested + 1, std::memory_order_release);
+        } else {
+            l.max_depth.store(std::max<uint64_t>(l.max_depth.load(std::memory_order_relaxed), live + 1), std::memory_order_relaxed);
+        }
+        l.accepted.store(l.accepted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Producer: enqueue on `lane`, applying the overflow policy when it is full.
+    PushResult push(size_t lane, const Message& message) {
+        while (!try_push(lane, message)) {
+            if (config.overflow != OverflowPolicy::BLOCK) {
+                Lane& l = *lanes[lane];
+                l.rejected.store(l.rejected.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return PushResult::REJECTED;
+            }
+            std::this_thread::yield();
+        }
+        return PushResult::ACCEPTED;
+    }
+
+    // Consumer: next message in round-robin lane order. Returns false if all lanes are empty.
+    bool try_pop(Message& out) {
+        size_t lane;
+        Message* m = next(lane);
+        if (!m) return false;
+        out = std::move(*m);
+        take(lane);
+        return true;
+    }
+
+    // Consumer: move up to `max` messages (bounded by out.size()) into `out`, in the same
+    // round-robin order as try_pop. Returns the number taken; 0 if all lanes are empty.
+    size_t pop_batch(std::span<Message> out, size_t max) {
+        size_t limit = std::min(max, out.size());
+        size_t count = 0;
+        while (count < limit && try_pop(out[count])) ++count;
+        return count;
+    }
+
+    // Consumer: next message, yielding while all lanes are empty.
+    Message pop() {
+        size_t lane;
+        Message* m;
+        while (!(m = next(lane))) std::this_thread::yield();
+        Message out = std::move(*m);
+        take(lane);
+        return out;
+    }
+
+    // Consumer: true if every lane is empty.
+    bool empty() {
+        size_t count = std::min(registered.load(std::memory_order_acquire), lanes.size());
+        for (size_t i = 0; i < count; ++i) {
+            if (front(*lanes[i])) return false;
+        }
+        return true;
+    }
+
+    size_t producers() const { return registered.load(std::memory_order_acquire); }
+
+    IngressStats stats() const {
+        IngressStats s;
+        size_t count = std::min(registered.load(std::memory_order_acquire), lanes.size());
+        for (size_t i = 0; i < count; ++i) {
+            const Lane& l = *lanes[i];
+            uint64_t shed = l.shed_done.load(std::memory_order_relaxed);
+            uint64_t pending = l.shed_requested.load(std::memory_order_relaxed) - shed;
+            uint64_t depth = l.ring.size();
+            s.depth += depth > pending ? depth - pending : 0;
+            s.max_depth = std::max<uint64_t>(s.max_depth, l.max_depth.load(std::memory_order_relaxed));
+            s.accepted += l.accepted.load(std::memory_order_relaxed);
+            s.rejected += l.rejected.load(std::memory_order_relaxed);
+            s.shed += shed;
+        }
+        return s;
+    }
+
+private:
+    struct Lane {
+        Ring ring;
+        // Written by the producer only
+        alignas(CACHE_LINE) std::atomic<uint64_t> shed_requested{0};
+        std::atomic<uint64_t> accepted{0}, rejected{0}, max_depth{0};
+        // Written by the consumer only
+        alignas(CACHE_LINE) std::atomic<uint64_t> shed_done{0};
+    };
+
+    IngressConfig config;
+    std::vector<std::unique_ptr<Lane>> lanes;   // Preallocated; lane i belongs to producer i
+    std::atomic<size_t> registered{0};
+    size_t next_lane = 0;                       // Consumer's round-robin position
+
+    // Consumer: front of the first non-empty lane from the round-robin position.
+    Message* next(size_t& lane) {
+        size_t count = std::min(registered.load(std::memory_order_acquire), lanes.size());
+        for (size_t i = 0; i < count; ++i) {
+            lane = next_lane + i < count ? next_lane + i : next_lane + i - count;
+            if (Message* m = front(*lanes[lane])) return m;
+        }
+        return nullptr;
+    }
+
+    // Consumer: free the slot returned by next() and move on to the following lane.
+    void take(size_t lane) {
+        lanes[lane]->ring.pop();
+        size_t count = std::min(registered.load(std::memory_order_acquire), lanes.size());
+        next_lane = lane + 1 < count ? lane + 1 : 0;
+    }
+
+    // Consumer: oldest message of a lane after serving its shed requests, or nullptr.
+    Message* front(Lane& l) {
+        Message* m = l.ring.front();
+        uint64_t done = l.shed_done.load(std::memory_order_relaxed);
+        while (m && !is_cancel(*m) && l.shed_requested.load(std::memory_order_acquire) != done) {
+            l.ring.pop();
+            l.shed_done.store(++done, std::memory_order_release);
+            m = l.ring.front();
+        }
+        return m;
+    }
+};
+
+// Ingress of plain orders (no cancels, so no cancel priority).
+using OrderIngress = BasicOrderIngress<Order>;
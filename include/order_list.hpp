@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "order_store.hpp"
+
+// Intrusive doubly-linked FIFO of the orders resting at one price level.
+// Links live in the hot OrderNode records, so the list itself is just head/tail
+// handles; append, unlink and front access are O(1) and never copy an order.
+// The level also keeps its open quantity and order count, so depth queries
+// never have to walk the orders.
+struct OrderList {
+    OrderHandle head = NULL_HANDLE;
+    OrderHandle tail = NULL_HANDLE;
+    size_t count = 0;
+    int64_t total_qty = 0;       // Sum of remaining quantity of the orders at this level
+
+    bool empty() const { return head == NULL_HANDLE; }
+    size_t size() const { return count; }
+    int64_t quantity() const { return total_qty; }
+    OrderHandle front() const { return head; }
+
+    void push_back(OrderStore& store, OrderHandle h) {
+        OrderNode& node = store[h];
+        node.prev = tail;
+        node.next = NULL_HANDLE;
+        if (tail != NULL_HANDLE) store[tail].next = h; else head = h;
+        tail = h;
+        ++count;
+        total_qty += node.quantity;
+    }
+
+    // Take `qty` off an order at this level (fill or size reduction); it keeps its place.
+    void reduce(OrderStore& store, OrderHandle h, int qty) {
+        store[h].quantity -= qty;
+        total_qty -= qty;
+    }
+
+    // Unlink an order that is currently in this list.
+    void erase(OrderStore& store, OrderHandle h) {
+        OrderNode& node = store[h];
+        if (node.prev != NULL_HANDLE) store[node.prev].next = node.next; else head = node.next;
+        if (node.next != NULL_HANDLE) store[node.next].prev = node.prev; else tail = node.prev;
+        node.prev = node.next = NULL_HANDLE;
+        --count;
+        total_qty -= node.quantity;
+    }
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include "order.hpp"
+
+enum class MessageType : uint8_t { NEW, CANCEL, MODIFY };
+
+// A request to the matcher, as carried by the Engine's ingress.
+//  - NEW:    `order` is the incoming order
+//  - CANCEL: only order.order_id and order.symbol_id are used
+//  - MODIFY: order.order_id and order.symbol_id, with order.price and order.quantity
+//            as the new price and quantity
+struct OrderMessage {
+    MessageType type;
+    Order order;
+
+    static OrderMessage new_order(const Order& order) { return {MessageType::NEW, order}; }
+
+    static OrderMessage cancel(uint32_t symbol_id, int order_id) {
+        OrderMessage m{MessageType::CANCEL, Order(order_id, 0, Side::BUY, OrderType::LIMIT, Price(), 0)};
+        m.order.symbol_id = symbol_id;
+        return m;
+    }
+
+    static OrderMessage modify(uint32_t symbol_id, int order_id, Price new_price, int new_qty) {
+        OrderMessage m{MessageType::MODIFY, Order(order_id, 0, Side::BUY, OrderType::LIMIT, new_price, new_qty)};
+        m.order.symbol_id = symbol_id;
+        return m;
+    }
+};
+
+// Cancels get priority when an ingress lane is full (see OrderIngress).
+inline bool is_cancel(const Order&) { return false; }
+inline bool is_cancel(const OrderMessage& m) { return m.type == MessageType::CANCEL; }
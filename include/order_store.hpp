@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "order.hpp"
+
+// Handle of an order inside an OrderStore (index into its tables).
+using OrderHandle = uint32_t;
+constexpr OrderHandle NULL_HANDLE = UINT32_MAX;
+
+// Hot part of a resting order: everything matching and level walks touch.
+// Packed to 32 bytes so two records share a cache line.
+struct alignas(32) OrderNode {
+    Price price;                 // Limit price in ticks
+    int order_id;                // Unique order identifier
+    int quantity;                // Remaining open quantity
+    OrderHandle prev;            // Previous order at the same level (or free-list link)
+    OrderHandle next;            // Next order at the same level
+    Side side;                   // BUY or SELL
+};
+static_assert(sizeof(OrderNode) == 32, "hot order record must stay at 32 bytes");
+
+// Cold part of a resting order, kept in a parallel table indexed by the same handle.
+struct OrderCold {
+    long long timestamp;         // Time the order was created
+    uint64_t sequence;           // Arrival sequence inside the book (time priority)
+    Price stop_price;            // Stop price (for STOP/STOP_LIMIT orders)
+    int filled;                  // Quantity already filled
+    OrderType type;              // LIMIT, MARKET, STOP, or STOP_LIMIT
+    OrderStatus status;          // Current status of the order
+    bool triggered;              // True if stop order has been triggered
+};
+
+// Storage for resting orders split into hot and cold tables, with a free list
+// threaded through the hot records. Tables are preallocated for `capacity` orders
+// and only grow if that is exceeded; handles stay valid across growth.
+class OrderStore {
+    std::vector<OrderNode> hot;
+    std::vector<OrderCold> cold_;
+    OrderHandle free_list = NULL_HANDLE;
+    size_t in_use = 0;
+    uint64_t next_sequence = 0;
+
+    void grow(size_t capacity) {
+        size_t old = hot.size();
+        hot.resize(capacity);
+        cold_.resize(capacity);
+        for (size_t i = capacity; i-- > old;) {
+            hot[i].next = free_list;
+            free_list = static_cast<OrderHandle>(i);
+        }
+    }
+
+public:
+    explicit OrderStore(size_t capacity) { grow(capacity ? capacity : 1); }
+
+    // Store an order and return its handle. The hot quantity is the remaining open
+    // quantity; each stored order gets the next arrival sequence number.
+    OrderHandle acquire(const Order& o) {
+        if (free_list == NULL_HANDLE) grow(hot.size() * 2);
+        OrderHandle h = free_list;
+        free_list = hot[h].next;
+        hot[h] = OrderNode{o.price, o.order_id, o.quantity - o.filled, NULL_HANDLE, NULL_HANDLE, o.side};
+        cold_[h] = OrderCold{o.timestamp, next_sequence++, o.stop_price, o.filled, o.type, o.status, o.triggered};
+        ++in_use;
+        return h;
+    }
+
+    // Give a stored order the next arrival sequence, as if it had just arrived.
+    void requeue(OrderHandle h) { cold_[h].sequence = next_sequence++; }
+
+    void release(OrderHandle h) {
+        hot[h].next = free_list;
+        free_list = h;
+        --in_use;
+    }
+
+    OrderNode& operator[](OrderHandle h) { return hot[h]; }
+    const OrderNode& operator[](OrderHandle h) const { return hot[h]; }
+    OrderCold& cold(OrderHandle h) { return cold_[h]; }
+    const OrderCold& cold(OrderHandle h) const { return cold_[h]; }
+
+    // Reassemble the full order (hot + cold) for re-submission or display.
+    Order to_order(OrderHandle h) const {
+        const OrderNode& n = hot[h];
+        const OrderCold& c = cold_[h];
+        Order o(n.order_id, c.timestamp, n.side, c.type, n.price, n.quantity + c.filled, c.stop_price);
+        o.filled = c.filled;
+        o.status = c.status;
+        o.triggered = c.triggered;
+        return o;
+    }
+
+    size_t size() const { return in_use; }
+    size_t capacity() const { return hot.size(); }
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "order_message.hpp"
+#include "spsc_ring.hpp"
+
+// Building blocks of the pipelined engine shard (see EngineConfig::pipelined).
+// Stages share one ring of events. Each stage owns a cursor counting the events it
+// has finished; a stage only reads events below its upstream stage's cursor, and the
+// first stage only reuses a slot once the last stage's cursor has passed it, so no
+// slot is ever written by two stages at once and no locks are needed.
+
+// Progress of one stage, alone on its cache line.
+struct alignas(CACHE_LINE) StageCursor {
+    std::atomic<uint64_t> value{0};    // Events this stage has finished
+    std::atomic<bool> done{false};     // The stage has exited; value is final
+};
+
+struct PipelineEvent {
+    OrderMessage message;
+    uint64_t sequence = 0;                 // Shard sequence number, set by the sequence stage
+    long long received_ns = 0;             // When the validate stage took the message
+    const char* reject_reason = nullptr;   // Set by validate; later stages skip the event
+};
+
+// A trade, handed from the match stage to the publish stage.
+struct FillEvent {
+    uint64_t sequence;       // Of the taker's event
+    int taker_id;
+    int maker_id;
+    uint32_t symbol_id;
+    Side taker_side;
+    Price price;
+    int quantity;
+    long long received_ns;   // Of the taker's event
+};
+
+struct Pipeline {
+    static constexpr size_t SIZE = 1 << 12;   // Events in flight per shard
+    static constexpr size_t MASK = SIZE - 1;
+    static constexpr size_t FILL_CAPACITY = 1 << 14;
+
+    std::vector<PipelineEvent> events = std::vector<PipelineEvent>(SIZE, PipelineEvent{OrderMessage::cancel(0, 0)});
+    StageCursor validated, sequenced, matched, published;
+    SpscRing<FillEvent, FILL_CAPACITY> fills;   // Match stage -> publish stage
+
+    PipelineEvent& at(uint64_t position) { return events[position & MASK]; }
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <compare>
+#include <limits>
+
+// Tick size used when an instrument does not specify its own.
+constexpr double DEFAULT_TICK_SIZE = 0.01;
+
+// Price is a fixed-point price stored as a whole number of ticks.
+// All book keys and comparisons use the integer tick count; conversion
+// from/to double only happens at the edges (order entry, GUI, console output).
+struct Price {
+    int64_t ticks = 0;           // Price expressed in ticks of the instrument
+
+    constexpr Price() = default;
+    constexpr explicit Price(int64_t t) : ticks(t) {}
+
+    // Round a decimal price to the nearest tick.
+    static Price from_double(double px, double tick_size = DEFAULT_TICK_SIZE) {
+        return Price(static_cast<int64_t>(std::llround(px / tick_size)));
+    }
+
+    // Convert back to a decimal price for display.
+    constexpr double to_double(double tick_size = DEFAULT_TICK_SIZE) const {
+        return static_cast<double>(ticks) * tick_size;
+    }
+
+    constexpr auto operator<=>(const Price&) const = default;
+
+    constexpr Price operator+(int64_t n) const { return Price(ticks + n); }
+    constexpr Price operator-(int64_t n) const { return Price(ticks - n); }
+    constexpr int64_t operator-(const Price& other) const { return ticks - other.ticks; }
+};
+
+// Sentinel for "no price" (empty side of the book, no trade yet).
+constexpr Price NO_PRICE = Price(std::numeric_limits<int64_t>::min());
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include "order.hpp"
+#include "object_pool.hpp"
+
+// A price ladder holds the price levels of one side of the book, ordered so that
+// the best price (highest bid / lowest ask) comes first. Two backends share the
+// same interface and are selected at build time:
+//   MapLadder   - std::map keyed by price (default)
+//   ArrayLadder - contiguous array indexed by tick offset, enabled with LOB_ARRAY_LADDER
+//
+// Both are constructed with the expected number of live levels so that steady-state
+// inserts do not allocate, and with the widest window (in ticks) the ArrayLadder may
+// grow to; MapLadder ignores it.
+//
+// Interface used by OrderBook, Matcher and the GUI:
+//   empty(), size()              - level count
+//   best_price(), best()         - best level (ladder must not be empty)
+//   find(price)                  - level at price or nullptr
+//   operator[](price)            - level at price, created if missing
+//   erase(price)                 - drop the level at price
+//   for_each_level(f)            - visit levels best-first; f(Price, const Level&) returns false to stop
+
+// std::map backed ladder. Buy levels are sorted descending, sell levels ascending.
+// Map nodes come from a NodePool sized for `max_levels`.
+template <Side S, typename Level>
+class MapLadder {
+    using Compare = std::conditional_t<S == Side::BUY, std::greater<Price>, std::less<Price>>;
+    using Alloc = PoolAllocator<std::pair<const Price, Level>>;
+    NodePool level_pool;
+    std::map<Price, Level, Compare, Alloc> levels;
+
+public:
+    explicit MapLadder(size_t max_levels, size_t = 0) : level_pool(max_levels), levels(Compare(), Alloc(&level_pool)) {
+        // Bind the pool to the map's node size now rather than on the first insert
+        levels[Price()];
+        levels.clear();
+    }
+    MapLadder(const MapLadder&) = delete;
+    MapLadder& operator=(const MapLadder&) = delete;
+
+    bool empty() const { return levels.empty(); }
+    size_t size() const { return levels.size(); }
+
+    Price best_price() const { return levels.begin()->first; }
+    Level& best() { return levels.begin()->second; }
+
+    Level* find(Price price) {
+        auto it = levels.find(price);
+        return it == levels.end() ? nullptr : &it->second;
+    }
+
+    Level& operator[](Price price) { return levels[price]; }
+
+    void erase(Price price) { levels.erase(price); }
+
+    template <typename F>
+    void for_each_level(F&& f) const {
+        for (const auto& [price, level] : levels) {
+            if (!f(price, level)) break;
+        }
+    }
+};
+
+// Array backed ladder. Level i holds price base + i ticks. A hierarchical occupancy
+// bitmap (64-way fan-out per layer) finds the best level and the next non-empty level
+// with one find-first-set per layer. When a price falls outside the window the ladder
+// re-centers around the occupied range, growing the window if the range does not fit.
+// The window never grows past `max_window` ticks (rounded up to a power of two): a level that would need more (an
+// outlier price far from the book) is kept in a sparse overflow map instead.
+template <Side S, typename Level>
+class ArrayLadder {
+    static constexpr size_t NONE = SIZE_MAX;
+    using Compare = std::conditional_t<S == Side::BUY, std::greater<Price>, std::less<Price>>;
+
+    std::vector<Level> levels;
+    std::map<Price, Level, Compare> overflow;  // Occupied levels outside the window
+    size_t max_window;
+    std::vector<std::vector<uint64_t>> bits;  // bits[0] is per level, bits.back() is a single word
+    int64_t base = 0;                         // tick value of levels[0]
+    bool anchored = false;                    // base is set on the first insert
+    size_t count = 0;                         // number of occupied levels
+
+    void init(size_t window) {
+        levels.clear();
+        levels.resize(window);
+        bits.clear();
+        size_t n = window;
+        do {
+            n = (n + 63) / 64;
+            bits.emplace_back(n, 0);
+        } while (n > 1);
+        count = 0;
+    }
+
+    void set_bit(size_t i) {
+        for (auto& layer : bits) {
+            uint64_t& word = layer[i >> 6];
+            bool was_empty = word == 0;
+            word |= 1ULL << (i & 63);
+            if (!was_empty) break;
+            i >>= 6;
+        }
+    }
+
+    void clear_bit(size_t i) {
+        for (auto& layer : bits) {
+            uint64_t& word = layer[i >> 6];
+            word &= ~(1ULL << (i & 63));
+            if (word != 0) break;
+            i >>= 6;
+        }
+    }
+
+    // Walk down from a set bit at `layer` to the lowest/highest set level below it.
+    size_t descend_low(size_t layer, size_t i) const {
+        while (layer-- > 0) i = (i << 6) | __builtin_ctzll(bits[layer][i]);
+        return i;
+    }
+    size_t descend_high(size_t layer, size_t i) const {
+        while (layer-- > 0) i = (i << 6) | (63 - __builtin_clzll(bits[layer][i]));
+        return i;
+    }
+
+    size_t lowest() const {
+        size_t top = bits.size() - 1;
+        if (bits[top][0] == 0) return NONE;
+        return descend_low(top, __builtin_ctzll(bits[top][0]));
+    }
+    size_t highest() const {
+        size_t top = bits.size() - 1;
+        if (bits[top][0] == 0) return NONE;
+        return descend_high(top, 63 - __builtin_clzll(bits[top][0]));
+    }
+
+    // Next occupied index strictly above / below i.
+    size_t next_above(size_t i) const {
+        for (size_t layer = 0; layer < bits.size(); ++layer, i >>= 6) {
+            unsigned b = i & 63;
+            if (b == 63) continue;
+            uint64_t m = bits[layer][i >> 6] & (~0ULL << (b + 1));
+            if (m) return descend_low(layer, ((i >> 6) << 6) | __builtin_ctzll(m));
+        }
+        return NONE;
+    }
+    size_t next_below(size_t i) const {
+        for (size_t layer = 0; layer < bits.size(); ++layer, i >>= 6) {
+            unsigned b = i & 63;
+            if (b == 0) continue;
+            uint64_t m = bits[layer][i >> 6] & ((1ULL << b) - 1);
+            if (m) return descend_high(layer, ((i >> 6) << 6) | (63 - __builtin_clzll(m)));
+        }
+        return NONE;
+    }
+
+    size_t best_index() const { return S == Side::BUY ? highest() : lowest(); }
+    size_t next_index(size_t i) const { return S == Side::BUY ? next_below(i) : next_above(i); }
+
+    bool in_window(Price price) const {
+        return anchored && price.ticks >= base && price.ticks - base < (int64_t)levels.size();
+    }
+
+    // Move the window so that `price` and every level in the window fit, doubling it if
+    // needed up to max_window. Returns false, leaving the window alone, if they cannot fit.
+    bool recenter(Price price) {
+        int64_t lo = price.ticks, hi = price.ticks;
+        if (count > 0) {
+            lo = std::min(lo, base + (int64_t)lowest());
+            hi = std::max(hi, base + (int64_t)highest());
+        }
+        size_t cap = levels.size();
+        while (cap < max_window) cap *= 2;
+        if (hi - lo + 2 > (int64_t)cap) return false;
+        size_t window = levels.size();
+        while ((int64_t)window < 2 * (hi - lo + 1) && window < cap) window *= 2;
+
+        std::vector<Level> old_levels = std::move(levels);
+        std::vector<std::vector<uint64_t>> old_bits = std::move(bits);
+        int64_t old_base = base;
+        size_t occupied = count;
+
+        init(window);
+        base = (lo + hi) / 2 - (int64_t)window / 2;
+        anchored = true;
+
+        // Re-insert occupied levels by scanning the old layer-0 words
+        if (occupied > 0) {
+            for (size_t w = 0; w < old_bits[0].size(); ++w) {
+                for (uint64_t m = old_bits[0][w]; m; m &= m - 1) {
+                    size_t old_i = (w << 6) | __builtin_ctzll(m);
+                    size_t i = old_base + old_i - base;
+                    levels[i] = std::move(old_levels[old_i]);
+                    set_bit(i);
+                    ++count;
+                }
+            }
+        }
+        // Overflow levels the new window covers move into it
+        for (auto it = overflow.begin(); it != overflow.end();) {
+            if (!in_window(it->first)) {
+                ++it;
+                continue;
+            }
+            size_t i = it->first.ticks - base;
+            levels[i] = std::move(it->second);
+            set_bit(i);
+            ++count;
+            it = overflow.erase(it);
+        }
+        return true;
+    }
+
+    // The better of two prices for this side.
+    static bool better(Price a, Price b) { return Compare()(a, b); }
+
+public:
+    // The initial window covers `max_levels` ticks, rounded up to a power of two.
+    explicit ArrayLadder(size_t max_levels, size_t max_window = size_t(1) << 20) : max_window(max_window) {
+        size_t window = 64;
+        while (window < max_levels) window *= 2;
+        init(window);
+    }
+
+    bool empty() const { return count == 0 && overflow.empty(); }
+    size_t size() const { return count + overflow.size(); }
+    // Ticks covered by the window (what the ladder's memory scales with).
+    size_t window() const { return levels.size(); }
+
+    Price best_price() const {
+        if (count == 0) return overflow.begin()->first;
+        Price p(base + (int64_t)best_index());
+        return overflow.empty() || better(p, overflow.begin()->first) ? p : overflow.begin()->first;
+    }
+    Level& best() {
+        if (count == 0) return overflow.begin()->second;
+        size_t i = best_index();
+        return overflow.empty() || better(Price(base + (int64_t)i), overflow.begin()->first) ? levels[i] : overflow.begin()->second;
+    }
+
+    Level* find(Price price) {
+        if (!in_window(price)) {
+            if (overflow.empty()) return nullptr;
+            auto it = overflow.find(price);
+            return it == overflow.end() ? nullptr : &it->second;
+        }
+        size_t i = price.ticks - base;
+        return (bits[0][i >> 6] >> (i & 63)) & 1 ? &levels[i] : nullptr;
+    }
+
+    Level& operator[](Price price) {
+        if (!anchored && count == 0) {
+            base = price.ticks - (int64_t)levels.size() / 2;
+            anchored = true;
+        } else if (!in_window(price) && !recenter(price)) {
+            return overflow[price];
+        }
+        size_t i = price.ticks - base;
+        if (!((bits[0][i >> 6] >> (i & 63)) & 1)) {
+            set_bit(i);
+            ++count;
+        }
+        return levels[i];
+    }
+
+    void erase(Price price) {
+        if (!in_window(price)) {
+            overflow.erase(price);
+            return;
+        }
+        size_t i = price.ticks - base;
+        if (!((bits[0][i >> 6] >> (i & 63)) & 1)) return;
+        levels[i] = Level();
+        clear_bit(i);
+        --count;
+    }
+
+    // Merges the window with the overflow levels, best first
+    template <typename F>
+    void for_each_level(F&& f) const {
+        auto it = overflow.begin();
+        for (size_t i = best_index(); i != NONE; i = next_index(i)) {
+            Price price(base + (int64_t)i);
+            for (; it != overflow.end() && better(it->first, price); ++it) {
+                if (!f(it->first, it->second)) return;
+            }
+            if (!f(price, levels[i])) return;
+        }
+        for (; it != overflow.end(); ++it) {
+            if (!f(it->first, it->second)) return;
+        }
+    }
+};
+
+#ifdef LOB_ARRAY_LADDER
+template <Side S, typename Level>
+using PriceLadder = ArrayLadder<S, Level>;
+#else
+template <Side S, typename Level>
+using PriceLadder = MapLadder<S, Level>;
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "lock_policy.hpp"
+#include "order_message.hpp"
+
+// Driving recorded order flow into a sink. Sources are CsvOrderParser (csv_replay.hpp)
+// and EventFileReader (event_file.hpp); both expose
+//   bool next(OrderMessage&)   and   size_t bytes_consumed() const.
+
+enum class ReplayMode {
+    AFAP,     // As fast as the sink accepts
+    PACED     // Spaced by the recorded timestamps, scaled by the replay speed
+};
+
+inline const char* to_string(ReplayMode mode) { return mode == ReplayMode::AFAP ? "afap" : "paced"; }
+
+inline ReplayMode parse_replay_mode(std::string_view name) {
+    if (name == "afap") return ReplayMode::AFAP;
+    if (name == "paced") return ReplayMode::PACED;
+    throw std::invalid_argument("unknown replay mode: " + std::string(name));
+}
+
+struct ReplayConfig {
+    std::string path;                  // Empty: no replay
+    ReplayMode mode = ReplayMode::AFAP;
+    double speed = 1.0;                // PACED: 2.0 replays twice as fast as recorded
+
+    // Read LOB_REPLAY (CSV or binary event file), LOB_REPLAY_MODE (afap|paced) and LOB_REPLAY_SPEED.
+    // Throws std::invalid_argument on malformed values.
+    static ReplayConfig from_env() {
+        ReplayConfig config;
+        if (const char* v = std::getenv("LOB_REPLAY")) config.path = v;
+        if (const char* v = std::getenv("LOB_REPLAY_MODE")) config.mode = parse_replay_mode(v);
+        if (const char* v = std::getenv("LOB_REPLAY_SPEED")) {
+            char* end = nullptr;
+            config.speed = std::strtod(v, &end);
+            if (end == v || *end || !(config.speed > 0)) throw std::invalid_argument(std::string("bad LOB_REPLAY_SPEED: ") + v);
+        }
+        return config;
+    }
+};
+
+struct ReplayStats {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+
+    double msgs_per_s() const { return seconds > 0 ? messages / seconds : 0; }
+    double gb_per_s() const { return seconds > 0 ? bytes / seconds / 1e9 : 0; }
+};
+
+// Feed the events of `source` to sink(const OrderMessage&), which returns false to
+// stop the replay early. PACED mode holds each event until its timestamp, relative to
+// the first one and divided by `speed`, has elapsed: it sleeps through long gaps and
+// spins through the last 100 us.
+template <typename Source, typename Sink>
+ReplayStats replay(Source& source, Sink&& sink, ReplayMode mode = ReplayMode::AFAP, double speed = 1.0) {
+    using clock_type = std::chrono::steady_clock;
+    ReplayStats stats;
+    OrderMessage message = OrderMessage::cancel(0, 0);
+    auto start = clock_type::now();
+    long long first_ts = 0;
+    while (source.next(message)) {
+        if (mode == ReplayMode::PACED) {
+            if (stats.messages == 0) first_ts = message.order.timestamp;
+            auto due = start + std::chrono::nanoseconds(int64_t((message.order.timestamp - first_ts) / speed));
+            for (auto now = clock_type::now(); now < due; now = clock_type::now()) {
+                if (due - now > std::chrono::microseconds(200)) std::this_thread::sleep_for(due - now - std::chrono::microseconds(100));
+                else cpu_relax();
+            }
+        }
+        if (!sink(message)) break;
+        ++stats.messages;
+    }
+    stats.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    stats.bytes = source.bytes_consumed();
+    return stats;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include "spsc_ring.hpp"
+
+// Single-writer sequence lock for publishing a trivially copyable value to any
+// number of readers. The writer never waits; a reader retries only if a store
+// overlapped its copy. The payload is kept as relaxed atomic words, so a torn
+// read is detected by the sequence check rather than being a data race.
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "seqlock payload must be trivially copyable");
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> seq{0};   // Odd while a store is in progress
+    alignas(CACHE_LINE) std::atomic<uint64_t> words[WORDS] = {};
+
+public:
+    // Writer only.
+    void store(const T& value) {
+        uint64_t buf[WORDS] = {};
+        std::memcpy(buf, &value, sizeof(T));
+        uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) words[i].store(buf[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Copy the latest value into `out`. Returns false if a store overlapped the copy.
+    bool try_load(T& out) const {
+        uint64_t before = seq.load(std::memory_order_acquire);
+        if (before & 1) return false;
+        uint64_t buf[WORDS];
+        for (size_t i = 0; i < WORDS; ++i) buf[i] = words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) != before) return false;
+        std::memcpy(&out, buf, sizeof(T));
+        return true;
+    }
+
+    // Copy the latest consistent value, retrying while the writer is mid-store.
+    void load(T& out) const {
+        while (!try_load(out)) std::this_thread::yield();
+    }
+
+    // Number of completed stores.
+    uint64_t version() const { return seq.load(std::memory_order_acquire) / 2; }
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "order.hpp"
+
+struct SnapshotConfig {
+    uint64_t every = 0;     // Messages per shard between snapshots; 0: only on Engine::request_snapshot()
+    size_t keep = 2;        // Snapshots kept per shard; older ones, and journal segments they cover, are deleted
+
+    // Read LOB_SNAPSHOT_EVERY and LOB_SNAPSHOT_KEEP. Throws std::invalid_argument on
+    // malformed values.
+    static SnapshotConfig from_env() {
+        SnapshotConfig config;
+        auto number = [](const char* name, const char* v) {
+            size_t used = 0;
+            unsigned long long n = 0;
+            try { n = std::stoull(v, &used); } catch (const std::exception&) {}
+            if (used == 0 || v[used] != '\0') throw std::invalid_argument(std::string("bad ") + name + ": " + v);
+            return uint64_t(n);
+        };
+        if (const char* v = std::getenv("LOB_SNAPSHOT_EVERY")) config.every = number("LOB_SNAPSHOT_EVERY", v);
+        if (const char* v = std::getenv("LOB_SNAPSHOT_KEEP")) config.keep = number("LOB_SNAPSHOT_KEEP", v);
+        if (config.keep == 0) throw std::invalid_argument("LOB_SNAPSHOT_KEEP must be at least 1");
+        return config;
+    }
+};
+
+struct SnapshotStats {
+    uint64_t written = 0;
+    uint64_t failed = 0;
+    uint64_t max_fork_us = 0;   // Longest matcher stall, spent in fork()
+};
+
+// Snapshot of one shard's books at a journal sequence (<dir>/shard<k>-<sequence>.snap):
+//
+//   SnapshotHeader
+//   per book: SnapshotBookHeader, then SnapshotOrder[orders]
+//             (resting orders in for_each_order visit order, then pending stops)
+//   SnapshotTrailer                   order count and checksum of everything before it
+//
+// Fixed width and little-endian like the event and journal files. A file without a
+// valid trailer (e.g. cut short by a crash) is ignored by the loader.
+constexpr char SNAPSHOT_MAGIC[8] = {'L', 'O', 'B', 'S', 'N', 'A', 'P', '1'};
+constexpr char SNAPSHOT_END[8] = {'L', 'O', 'B', 'S', 'N', 'E', 'N', 'D'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t order_size;        // sizeof(SnapshotOrder) of the writer
+    uint64_t shard;
+    uint64_t sequence;          // Last journal sequence reflected in the books
+    double tick_size;
+    uint32_t books;
+    uint8_t padding[20];
+};
+static_assert(sizeof(SnapshotHeader) == 64);
+
+struct SnapshotBookHeader {
+    uint32_t symbol;
+    uint32_t reserved;
+    int64_t last_trade;         // Ticks, or NO_PRICE
+    uint64_t orders;
+    uint64_t padding;
+};
+static_assert(sizeof(SnapshotBookHeader) == 32);
+
+struct SnapshotOrder {
+    uint64_t arrival;           // Arrival sequence in the book (stop time priority)
+    int64_t price;
+    int64_t stop_price;
+    int64_t timestamp;
+    int32_t order_id;
+    int32_t quantity;
+    int32_t filled;
+    uint8_t side, type, status, triggered;
+};
+static_assert(sizeof(SnapshotOrder) == 48);
+
+struct SnapshotTrailer {
+    char magic[8];
+    uint64_t orders;
+    uint64_t checksum;
+    uint64_t reserved;
+};
+static_assert(sizeof(SnapshotTrailer) == 32);
+
+inline SnapshotOrder to_snapshot_order(const Order& o, uint64_t arrival) {
+    return SnapshotOrder{arrival, o.price.ticks, o.stop_price.ticks, o.timestamp, o.order_id, o.quantity, o.filled,
+                         uint8_t(o.side), uint8_t(o.type), uint8_t(o.status), uint8_t(o.triggered)};
+}
+
+inline Order to_order(const SnapshotOrder& s) {
+    Order o(s.order_id, s.timestamp, Side(s.side), OrderType(s.type), Price(s.price), s.quantity, Price(s.stop_price));
+    o.filled = s.filled;
+    o.status = OrderStatus(s.status);
+    o.triggered = s.triggered;
+    return o;
+}
+
+// Checksum over whole 64-bit words (every snapshot section is a multiple of 8 bytes).
+inline uint64_t snapshot_checksum(uint64_t h, const char* p, size_t n) {
+    for (size_t i = 0; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = (h ^ w) * 1099511628211ull;
+    }
+    return h;
+}
+constexpr uint64_t SNAPSHOT_CHECKSUM_SEED = 14695981039346656037ull;
+
+// Buffered writer of a snapshot file. Allocation-free and only uses write(), so it is
+// safe in a child forked from a multi-threaded process. Calls return false on I/O errors.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(int fd) : fd(fd) {}
+
+    bool put(const void* data, size_t n) {
+        const char* p = static_cast<const char*>(data);
+        while (n > 0) {
+            size_t k = std::min(n, sizeof(buffer) - used);
+            std::memcpy(buffer + used, p, k);
+            used += k;
+            p += k;
+            n -= k;
+            if (used == sizeof(buffer) && !flush()) return false;
+        }
+        return true;
+    }
+    bool add(const Order& o, uint64_t arrival) {
+        SnapshotOrder s = to_snapshot_order(o, arrival);
+        ++orders;
+        return put(&s, sizeof(s));
+    }
+    // Append the trailer and write out the buffer.
+    bool finish() {
+        if (!flush()) return false;
+        SnapshotTrailer t{};
+        std::memcpy(t.magic, SNAPSHOT_END, sizeof(t.magic));
+        t.orders = orders;
+        t.checksum = checksum;
+        std::memcpy(buffer, &t, sizeof(t));
+        used = sizeof(t);
+        return write_out();
+    }
+
+private:
+    int fd;
+    size_t used = 0;
+    uint64_t orders = 0;
+    uint64_t checksum = SNAPSHOT_CHECKSUM_SEED;
+    char buffer[1 << 16];
+
+    bool flush() {
+        checksum = snapshot_checksum(checksum, buffer, used);
+        return write_out();
+    }
+    bool write_out() {
+        const char* p = buffer;
+        while (used > 0) {
+            ssize_t w = ::write(fd, p, used);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += w;
+            used -= w;
+        }
+        return true;
+    }
+};
+
+// Validated view of a snapshot file held in memory (typically a MappedFile). The
+// constructor checks the header, the sizes and the trailer checksum and throws
+// std::runtime_error if anything is off.
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size) : base(data) {
+        if (size < sizeof(SnapshotHeader) + sizeof(SnapshotTrailer)) throw std::runtime_error("truncated snapshot");
+        std::memcpy(&head, data, sizeof(head));
+        if (std::memcmp(head.magic, SNAPSHOT_MAGIC, sizeof(head.magic)) != 0) throw std::runtime_error("not a snapshot");
+        if (head.version != SNAPSHOT_VERSION || head.order_size != sizeof(SnapshotOrder))
+            throw std::runtime_error("unsupported snapshot version");
+        SnapshotTrailer trailer;
+        std::memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+        if (std::memcmp(trailer.magic, SNAPSHOT_END, sizeof(trailer.magic)) != 0) throw std::runtime_error("incomplete snapshot");
+        body = size - sizeof(trailer);
+        if (snapshot_checksum(SNAPSHOT_CHECKSUM_SEED, data, body) != trailer.checksum) throw std::runtime_error("snapshot checksum mismatch");
+        // Walk the book sections once to check they tile the body exactly
+        size_t offset = sizeof(SnapshotHeader);
+        uint64_t orders = 0;
+        for (uint32_t b = 0; b < head.books; ++b) {
+            if (body - offset < sizeof(SnapshotBookHeader)) throw std::runtime_error("truncated snapshot");
+            SnapshotBookHeader book;
+            std::memcpy(&book, data + offset, sizeof(book));
+            offset += sizeof(book);
+            if ((body - offset) / sizeof(SnapshotOrder) < book.orders) throw std::runtime_error("truncated snapshot");
+            offset += book.orders * sizeof(SnapshotOrder);
+            orders += book.orders;
+        }
+        if (offset != body || orders != trailer.orders) throw std::runtime_error("snapshot size mismatch");
+    }
+
+    const SnapshotHeader& header() const { return head; }
+    uint64_t sequence() const { return head.sequence; }
+
+    // f(const SnapshotBookHeader&, const SnapshotOrder* orders) for every book.
+    template <typename F>
+    void for_each_book(F&& f) const {
+        size_t offset = sizeof(SnapshotHeader);
+        for (uint32_t b = 0; b < head.books; ++b) {
+            SnapshotBookHeader book;
+            std::memcpy(&book, base + offset, sizeof(book));
+            offset += sizeof(book);
+            f(book, reinterpret_cast<const SnapshotOrder*>(base + offset));
+            offset += book.orders * sizeof(SnapshotOrder);
+        }
+    }
+
+private:
+    const char* base;
+    size_t body;
+    SnapshotHeader head;
+};
+
+inline std::string snapshot_path(const std::string& dir, size_t shard, uint64_t sequence) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "shard%zu-%020llu.snap", shard, (unsigned long long)sequence);
+    return dir + "/" + name;
+}
+
+// Snapshots of `shard` in `dir` as (sequence, path), oldest first.
+inline std::vector<std::pair<uint64_t, std::string>> list_snapshots(const std::string& dir, size_t shard) {
+    std::vector<std::pair<uint64_t, std::string>> found;
+    std::string prefix = "shard" + std::to_string(shard) + "-";
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) != 0 || entry.path().extension() != ".snap") continue;
+        found.emplace_back(std::stoull(name.substr(prefix.size())), entry.path().string());
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Size of a cache line; producer and consumer state live on separate lines.
+constexpr size_t CACHE_LINE = 64;
+
+// Bounded lock-free single-producer/single-consumer ring.
+// Capacity is a power of two so positions wrap with a mask. Head and tail are
+// monotonically increasing counters published with release stores and read with
+// acquire loads; each side also caches the other side's counter so the shared line
+// is only touched when the ring looks full (producer) or empty (consumer).
+// Elements are constructed in place in the slot and moved out on pop.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct Slot {
+        alignas(T) unsigned char bytes[sizeof(T)];
+        T* get() { return std::launder(reinterpret_cast<T*>(bytes)); }
+    };
+
+    // Consumer line
+    alignas(CACHE_LINE) std::atomic<size_t> head{0};   // Next slot to read
+    size_t tail_cache = 0;                             // Consumer's last view of tail
+    // Producer line
+    alignas(CACHE_LINE) std::atomic<size_t> tail{0};   // Next slot to write
+    size_t head_cache = 0;                             // Producer's last view of head
+    alignas(CACHE_LINE) std::unique_ptr<Slot[]> slots{new Slot[Capacity]};
+
+public:
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+    ~SpscRing() {
+        while (front()) pop();
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    // Producer: construct an element in the next free slot. Returns false if full.
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head_cache == Capacity) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t - head_cache == Capacity) return false;
+        }
+        new (slots[t & MASK].bytes) T(std::forward<Args>(args)...);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& item) { return try_emplace(item); }
+
+    // Consumer: oldest element, or nullptr if empty. Stays valid until pop().
+    T* front() {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail_cache) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h == tail_cache) return nullptr;
+        }
+        return slots[h & MASK].get();
+    }
+
+    // Consumer: destroy the element returned by front() and free its slot.
+    void pop() {
+        size_t h = head.load(std::memory_order_relaxed);
+        slots[h & MASK].get()->~T();
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // Consumer: move the oldest element into `out`. Returns false if empty.
+    bool try_pop(T& out) {
+        T* item = front();
+        if (!item) return false;
+        out = std::move(*item);
+        pop();
+        return true;
+    }
+
+    // Approximate when called concurrently with the other side.
+    size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <climits>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include "wait_strategy.hpp"
+
+// Pin a thread to one CPU. cpu < 0 leaves it unpinned. Returns false if the OS refused.
+inline bool pin_thread(std::thread::native_handle_type thread, int cpu) {
+    if (cpu < 0) return true;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+}
+
+inline bool pin_current_thread(int cpu) { return pin_thread(pthread_self(), cpu); }
+
+// CPU of the i-th thread of a role: cpus are assigned round-robin; -1 if none are given.
+inline int cpu_for(const std::vector<int>& cpus, size_t i) {
+    return cpus.empty() ? -1 : cpus[i % cpus.size()];
+}
+
+inline const char* to_string(WaitStrategy strategy) {
+    switch (strategy) {
+        case WaitStrategy::BLOCKING:   return "blocking";
+        case WaitStrategy::SPIN:       return "spin";
+        case WaitStrategy::SPIN_YIELD: return "spin_yield";
+        default:                       return "spin_park";
+    }
+}
+
+inline WaitStrategy parse_wait_strategy(std::string_view name) {
+    for (WaitStrategy s : {WaitStrategy::BLOCKING, WaitStrategy::SPIN, WaitStrategy::SPIN_YIELD, WaitStrategy::SPIN_PARK}) {
+        if (name == to_string(s)) return s;
+    }
+    throw std::invalid_argument("unknown wait strategy: " + std::string(name));
+}
+
+// Parse a CPU list such as "2,3,6". Empty means unpinned.
+inline std::vector<int> parse_cpu_list(std::string_view list) {
+    std::vector<int> cpus;
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string item(list.substr(0, comma));
+        size_t used = 0;
+        int cpu = -1;
+        try { cpu = std::stoi(item, &used); } catch (const std::exception&) {}
+        if (cpu < 0 || used != item.size()) throw std::invalid_argument("bad CPU list entry: " + item);
+        cpus.push_back(cpu);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+    }
+    return cpus;
+}
+
+// Thread placement per role and the matcher's wait strategy. Everything defaults to
+// unpinned threads and SPIN_YIELD. Pin the matcher (and, with SPIN, give it a core of
+// its own) to keep it from migrating; put the logger and GUI away from it.
+struct ThreadConfig {
+    std::vector<int> producer_cpus;   // Producer i runs on producer_cpus[i % size]
+    std::vector<int> matcher_cpus;    // Matcher shard i runs on matcher_cpus[i % size]
+    int logger_cpu = -1;
+    int gui_cpu = -1;
+    WaitStrategy matcher_wait = WaitStrategy::SPIN_YIELD;
+    unsigned spin_polls = 1000;       // Empty polls before SPIN_YIELD/SPIN_PARK back off
+    bool pipelined = false;           // Four stage threads per shard (matcher_cpus[4i..4i+3])
+
+    // Read LOB_PRODUCER_CPUS, LOB_MATCHER_CPUS (CPU lists), LOB_LOGGER_CPU, LOB_GUI_CPU,
+    // LOB_MATCHER_WAIT (blocking|spin|spin_yield|spin_park), LOB_SPIN_POLLS and LOB_PIPELINED (0|1).
+    // Throws std::invalid_argument on malformed values.
+    static ThreadConfig from_env() {
+        ThreadConfig config;
+        auto single = [](const char* list) {
+            std::vector<int> cpus = parse_cpu_list(list);
+            if (cpus.size() != 1) throw std::invalid_argument(std::string("expected one CPU, got: ") + list);
+            return cpus[0];
+        };
+        if (const char* v = std::getenv("LOB_PRODUCER_CPUS")) config.producer_cpus = parse_cpu_list(v);
+        if (const char* v = std::getenv("LOB_MATCHER_CPUS")) config.matcher_cpus = parse_cpu_list(v);
+        if (const char* v = std::getenv("LOB_LOGGER_CPU")) config.logger_cpu = single(v);
+        if (const char* v = std::getenv("LOB_GUI_CPU")) config.gui_cpu = single(v);
+        if (const char* v = std::getenv("LOB_MATCHER_WAIT")) config.matcher_wait = parse_wait_strategy(v);
+        if (const char* v = std::getenv("LOB_SPIN_POLLS")) {
+            // One non-negative integer; stoull would wrap a leading '-'
+            size_t used = 0;
+            unsigned long long polls = 0;
+            if (*v != '-') {
+                try { polls = std::stoull(v, &used); } catch (const std::exception&) {}
+            }
+            if (used == 0 || v[used] != '\0' || polls > UINT_MAX)
+                throw std::invalid_argument(std::string("bad LOB_SPIN_POLLS (expected a poll count): ") + v);
+            config.spin_polls = unsigned(polls);
+        }
+        if (const char* v = std::getenv("LOB_PIPELINED")) {
+            std::string flag(v);
+            if (flag != "0" && flag != "1") throw std::invalid_argument("bad LOB_PIPELINED: " + flag);
+            config.pipelined = flag == "1";
+        }
+        return config;
+    }
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "order.hpp"
+#include "spsc_ring.hpp"
+
+struct TradeTapeConfig {
+    std::string dir;                            // Empty: no tape
+    size_t segment_bytes = size_t(64) << 20;    // A new file is started once a file reaches this size
+
+    // Throws std::invalid_argument if a file cannot hold its header and one record.
+    void validate() const;
+    // Read LOB_TAPE_DIR and LOB_TAPE_SEGMENT_MB. Throws std::invalid_argument on
+    // malformed values.
+    static TradeTapeConfig from_env();
+};
+
+// One fill as stored on the tape.
+struct TradeRecord {
+    uint64_t trade_id;          // Per shard, consecutive across files and restarts
+    int64_t timestamp_ns;       // Wall clock (system_clock) when the fill was recorded
+    int64_t latency_ns;         // steady_clock, from the start of the taker's match (or, pipelined, its receipt) to the fill
+    int64_t price;              // Ticks
+    int32_t taker_id;
+    int32_t maker_id;
+    int32_t quantity;
+    uint32_t symbol;
+    uint8_t taker_side;         // Side
+    uint8_t reserved[15];
+};
+static_assert(sizeof(TradeRecord) == 64);
+
+// Tape file: this header, then TradeRecord[] up to the end of the file.
+struct TradeTapeHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t shard;
+    uint64_t first_trade;       // trade_id of the file's first record
+    double tick_size;
+    uint8_t padding[24];
+};
+static_assert(sizeof(TradeTapeHeader) == 64);
+
+constexpr char TRADE_TAPE_MAGIC[8] = {'L', 'O', 'B', 'T', 'A', 'P', 'E', '1'};
+constexpr uint32_t TRADE_TAPE_VERSION = 1;
+
+struct TradeTapeStats {
+    uint64_t records = 0;
+    uint64_t writes = 0;        // write() calls
+    uint64_t bytes = 0;
+    uint64_t files = 0;
+    uint64_t full = 0;          // Appends that found the ring full and waited
+};
+
+// Trade tape of one shard. The thread that matches (or publishes, when pipelined)
+// appends fixed-size records to a lock-free ring and never makes a system call; a
+// tape thread wakes every millisecond, drains the ring into a buffer and writes it
+// out with one large sequential write() once it holds WRITE_RECORDS records or has
+// waited FLUSH_INTERVAL. Files (<dir>/shard<k>-<first trade>.tape) are rotated at
+// segment_bytes. The tape is not synced: a crash loses the trades still buffered.
+class TradeTape {
+public:
+    // Continues the trade numbering of the shard's existing files and starts the tape
+    // thread; files are created on the first write. Throws std::runtime_error if the
+    // directory cannot be created. A failed write aborts the process, as in the journal.
+    TradeTape(const TradeTapeConfig& config, size_t shard, double tick_size);
+    ~TradeTape() { close(); }
+    TradeTape(const TradeTape&) = delete;
+    TradeTape& operator=(const TradeTape&) = delete;
+
+    // Appending thread: add a fill; waits (yielding) while the ring is full.
+    void append(uint32_t symbol, Side taker_side, int taker_id, int maker_id, Price price, int quantity,
+                int64_t timestamp_ns, int64_t latency_ns) {
+        TradeRecord r{};
+        r.trade_id = next_trade++;
+        r.timestamp_ns = timestamp_ns;
+        r.latency_ns = latency_ns;
+        r.price = price.ticks;
+        r.taker_id = taker_id;
+        r.maker_id = maker_id;
+        r.quantity = quantity;
+        r.symbol = symbol;
+        r.taker_side = uint8_t(taker_side);
+        if (ring.try_push(r)) return;
+        full.fetch_add(1, std::memory_order_relaxed);
+        while (!ring.try_push(r)) std::this_thread::yield();
+    }
+
+    // Write out everything appended, then stop the tape thread and close the file.
+    void close();
+
+    // Tape-thread counters; call while the tape is idle for exact values.
+    TradeTapeStats stats() const;
+
+    // Tape files of `shard` in `dir` as (first trade, path), oldest first.
+    static std::vector<std::pair<uint64_t, std::string>> files(const std::string& dir, size_t shard);
+
+private:
+    static constexpr size_t RING_CAPACITY = 1 << 16;
+    static constexpr size_t WRITE_RECORDS = 1 << 14;   // 1 MB per write()
+    static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(100);
+
+    TradeTapeConfig config;
+    size_t shard;
+    double tick_size;
+    int fd = -1;
+    uint64_t offset = 0;                               // Size of the current file
+    uint64_t next_trade = 1;                           // Owned by the appending thread
+    uint64_t written_trades = 1;                       // trade_id of the next record written
+    std::vector<TradeRecord> buffer;
+    SpscRing<TradeRecord, RING_CAPACITY> ring;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> records{0}, writes{0}, bytes{0}, files_opened{0}, full{0};
+    std::thread writer;
+
+    void run();
+    void write_buffer(size_t n);
+    void open_file(uint64_t first_trade);
+    void close_file();
+};
+
+// Validated view of a tape file held in memory (typically a MappedFile). Throws
+// std::runtime_error on a foreign or unsupported header; a partly written last record
+// is ignored.
+class TradeTapeReader {
+public:
+    TradeTapeReader(const char* data, size_t size) {
+        if (size < sizeof(TradeTapeHeader)) throw std::runtime_error("truncated trade tape");
+        std::memcpy(&head, data, sizeof(head));
+        if (std::memcmp(head.magic, TRADE_TAPE_MAGIC, sizeof(head.magic)) != 0) throw std::runtime_error("not a trade tape");
+        if (head.version != TRADE_TAPE_VERSION || head.record_size != sizeof(TradeRecord))
+            throw std::runtime_error("unsupported trade tape version");
+        first = reinterpret_cast<const TradeRecord*>(data + sizeof(head));
+        count = (size - sizeof(head)) / sizeof(TradeRecord);
+    }
+
+    const TradeTapeHeader& header() const { return head; }
+    double tick_size() const { return head.tick_size; }
+    size_t size() const { return count; }
+    const TradeRecord* begin() const { return first; }
+    const TradeRecord* end() const { return first + count; }
+
+private:
+    TradeTapeHeader head;
+    const TradeRecord* first;
+    size_t count;
+};
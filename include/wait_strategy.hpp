@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "lock_policy.hpp"
+
+// How an idle consumer waits for work.
+//  - BLOCKING:   sleep in the kernel as soon as a poll comes up empty; lowest CPU use,
+//                pays a wakeup on the first order after every idle period
+//  - SPIN:       busy-poll with a pause hint; lowest latency, burns its core
+//  - SPIN_YIELD: busy-poll for spin_polls empty polls, then yield between polls
+//  - SPIN_PARK:  busy-poll, then yield, then sleep as BLOCKING does
+enum class WaitStrategy { BLOCKING, SPIN, SPIN_YIELD, SPIN_PARK };
+
+// Idle loop of a single consumer, shared with the producers that feed it.
+// Parking uses a futex-backed atomic wait: the consumer announces it is parked and
+// re-checks for work before sleeping, and producers call notify() after publishing,
+// so a wakeup is never lost. Producers only pay for notify() (a fence and a load)
+// with the parking strategies.
+class IdleWaiter {
+public:
+    explicit IdleWaiter(WaitStrategy strategy = WaitStrategy::SPIN_YIELD, unsigned spin_polls = 1000)
+        : strategy(strategy), spin_polls(spin_polls) {}
+
+    WaitStrategy wait_strategy() const { return strategy; }
+    bool parks() const { return strategy == WaitStrategy::BLOCKING || strategy == WaitStrategy::SPIN_PARK; }
+
+    // Consumer: called after a poll found no work; `idle_polls` counts the empty polls
+    // since the last work. Returns when the caller should poll again. `has_work` must
+    // also return true when the consumer is asked to stop.
+    template <typename HasWork>
+    void idle(unsigned idle_polls, HasWork&& has_work) {
+        switch (strategy) {
+            case WaitStrategy::SPIN:
+                cpu_relax();
+                return;
+            case WaitStrategy::SPIN_YIELD:
+                if (idle_polls < spin_polls) cpu_relax(); else std::this_thread::yield();
+                return;
+            case WaitStrategy::SPIN_PARK:
+                if (idle_polls < spin_polls) cpu_relax();
+                else if (idle_polls < 2 * spin_polls) std::this_thread::yield();
+                else park(has_work);
+                return;
+            case WaitStrategy::BLOCKING:
+                park(has_work);
+                return;
+        }
+    }
+
+    // Producer: call after publishing work.
+    void notify() {
+        if (!parks()) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);   // publish before reading `parked`
+        if (parked.load(std::memory_order_relaxed)) wake();
+    }
+
+    // Wake the consumer unconditionally (e.g. after asking it to stop).
+    void wake() {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        epoch.notify_all();
+    }
+
+private:
+    WaitStrategy strategy;
+    unsigned spin_polls;
+    std::atomic<uint32_t> epoch{0};     // Bumped by every wakeup
+    std::atomic<bool> parked{false};
+
+    template <typename HasWork>
+    void park(HasWork& has_work) {
+        uint32_t seen = epoch.load(std::memory_order_acquire);
+        parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);   // announce before re-checking
+        if (!has_work()) epoch.wait(seen, std::memory_order_acquire);
+        parked.store(false, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,19 @@
+#include "alloc_counter.hpp"
+#include <cstdlib>
+#include <new>
+
+// Replacement global allocation functions that count allocations per thread.
+// Only linked into test/zero_alloc_test (make test_zero_alloc); array and nothrow forms
+// forward to these by default.
+static thread_local size_t thread_alloc_count = 0;
+
+size_t thread_allocations() { return thread_alloc_count; }
+
+void* operator new(size_t size) {
+    ++thread_alloc_count;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
@@ -0,0 +1,632 @@
+#include "engine.hpp"
+#include "thread_config.hpp"
+#include "utils/logger.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+
+static long long now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Engine::Engine(const EngineConfig& config_) : config(config_) {
+    if (config.shards == 0) config.shards = 1;
+    for (size_t s = 0; s < config.symbols; ++s) {
+        books.push_back(make_unique<Book>(config.book));
+        views.push_back(make_unique<Seqlock<BookSnapshot>>());
+        BookSnapshot empty;
+        books.back()->snapshot(empty);
+        views.back()->store(empty);
+    }
+    for (size_t i = 0; i < config.shards; ++i) {
+        shard_list.push_back(make_unique<Shard>(config.max_producers, config.ingress, i, config.wait, config.spin_polls));
+    }
+}
+
+Engine::~Engine() {
+    stop();
+}
+
+void Engine::start() {
+    if (running()) return;
+    open_journals();
+    if (!config.tape.dir.empty()) {
+        for (auto& shard : shard_list) {
+            shard->tape = make_unique<TradeTape>(config.tape, shard->index, config.book.tick_size);
+            shard->matcher = Matcher(shard->tape.get());
+        }
+    }
+    if (!config.journal.dir.empty()) {
+        reaper_stopping = false;
+        reaper = thread([this] { run_reaper(); });
+    }
+    running_.store(true, memory_order_release);
+    for (auto& shard : shard_list) {
+        Shard* s = shard.get();
+        if (!config.pipelined) {
+            s->thread = thread([this, s] { run_shard(*s); });
+            continue;
+        }
+        s->pipeline = make_unique<Pipeline>();
+        s->thread = thread([this, s] { run_validate(*s); });
+        s->stages[0] = thread([this, s] { run_sequence(*s); });
+        s->stages[1] = thread([this, s, applied = s->sequence] { run_match(*s, applied); });
+        s->stages[2] = thread([this, s] { run_publish(*s); });
+    }
+}
+
+void Engine::stop() {
+    running_.store(false, memory_order_release);
+    for (auto& shard : shard_list) shard->waiter.wake();
+    for (auto& shard : shard_list) {
+        if (shard->thread.joinable()) shard->thread.join();
+        for (auto& stage : shard->stages) {
+            if (stage.joinable()) stage.join();
+        }
+        if (shard->journal) {
+            shard->journal->close();   // Writes out the tail
+            JournalStats s = shard->journal->stats();
+            closed_journals.records += s.records;
+            closed_journals.groups += s.groups;
+            closed_journals.bytes += s.bytes;
+            closed_journals.segments += s.segments;
+            shard->journal.reset();
+        }
+        if (shard->tape) {
+            shard->matcher = Matcher();
+            shard->tape->close();   // Writes out the buffered trades
+            TradeTapeStats s = shard->tape->stats();
+            closed_tapes.records += s.records;
+            closed_tapes.writes += s.writes;
+            closed_tapes.bytes += s.bytes;
+            closed_tapes.files += s.files;
+            closed_tapes.full += s.full;
+            shard->tape.reset();
+        }
+    }
+    if (reaper.joinable()) {
+        {
+            lock_guard<mutex> lock(reaper_mutex);
+            reaper_stopping = true;
+        }
+        reaper_cv.notify_one();
+        reaper.join();   // Waits for snapshots still being written
+    }
+}
+
+void Engine::open_journals() {
+    if (config.journal.dir.empty()) return;
+    if (config.journal.recover && !journal_replayed) {
+        filesystem::create_directories(config.journal.dir);
+        for (auto& shard : shard_list) {
+            shard->sequence = load_snapshot(*shard);
+            shard->snapshot_sequence = shard->sequence;
+            shard->sequence = Journal::recover(config.journal.dir, shard->index, shard->sequence,
+                                               [&](uint64_t, const OrderMessage& message) {
+                Order incoming = message.order;
+                if (incoming.symbol_id >= books.size()) return;
+                Book& book = *books[incoming.symbol_id];
+                switch (message.type) {
+                    case MessageType::NEW: Matcher::match_order(incoming, book, [](int, Price, int) {}); break;
+                    case MessageType::CANCEL: book.cancel_order(incoming.order_id); break;
+                    case MessageType::MODIFY: book.modify_order(incoming.order_id, incoming.price, incoming.quantity); break;
+                }
+                ++recovered_;
+            });
+        }
+        BookSnapshot snapshot;
+        for (size_t symbol = 0; symbol < books.size(); ++symbol) {
+            books[symbol]->snapshot(snapshot);
+            views[symbol]->store(snapshot);
+        }
+        if (restored_ || recovered_) LOG_INFO("Restored {} orders from snapshots, replayed {} journaled messages", restored_, recovered_);
+    }
+    journal_replayed = true;
+    for (auto& shard : shard_list) {
+        // As for the journal's stale segments: a snapshot past the recovery point would be
+        // loaded on the next start in place of the history written from here on
+        for (const auto& [sequence, path] : list_snapshots(config.journal.dir, shard->index)) {
+            error_code ec;
+            if (sequence > shard->sequence) filesystem::remove(path, ec);
+        }
+        shard->journal = make_unique<Journal>(config.journal, shard->index, shard->sequence + 1);
+    }
+}
+
+uint64_t Engine::load_snapshot(Shard& shard) {
+    vector<pair<uint64_t, string>> snapshots = list_snapshots(config.journal.dir, shard.index);
+    vector<pair<uint64_t, Order>> stops;
+    // Newest first; a snapshot that fails validation is skipped for the one before it
+    for (auto it = snapshots.rbegin(); it != snapshots.rend(); ++it) {
+        try {
+            MappedFile file(it->second);
+            SnapshotReader reader(file.data(), file.size());
+            if (reader.header().shard != shard.index || reader.header().tick_size != config.book.tick_size) {
+                throw runtime_error("snapshot of another shard or tick size");
+            }
+            reader.for_each_book([&](const SnapshotBookHeader& b, const SnapshotOrder*) {
+                if (b.symbol >= books.size() || shard_of(b.symbol) != shard.index) throw runtime_error("symbol outside the shard");
+            });
+            reader.for_each_book([&](const SnapshotBookHeader& b, const SnapshotOrder* orders) {
+                Book& book = *books[b.symbol];
+                // Resting orders keep their queue order; pending stops go back in arrival order
+                stops.clear();
+                for (uint64_t i = 0; i < b.orders; ++i) {
+                    Order o = to_order(orders[i]);
+                    bool pending_stop = (o.type == OrderType::STOP || o.type == OrderType::STOP_LIMIT) && !o.triggered;
+                    if (pending_stop) stops.emplace_back(orders[i].arrival, o);
+                    else book.restore_order(o);
+                }
+                sort(stops.begin(), stops.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+                for (const auto& stop : stops) book.restore_order(stop.second);
+                book.restore_last_trade(Price(b.last_trade));
+                restored_ += b.orders;
+            });
+            LOG_INFO("Shard {} restored from its snapshot at sequence {}", shard.index, reader.sequence());
+            return reader.sequence();
+        } catch (const exception&) {
+            LOG_WARN("Skipping unreadable snapshot of shard {} at sequence {}", shard.index, it->first);
+        }
+    }
+    return 0;
+}
+
+void Engine::request_snapshot() {
+    for (auto& shard : shard_list) {
+        shard->snapshot_requested.store(true, memory_order_release);
+        shard->waiter.wake();
+    }
+}
+
+SnapshotStats Engine::snapshot_stats() const {
+    return {snapshots_written.load(memory_order_acquire), snapshots_failed.load(memory_order_acquire),
+            max_fork_us.load(memory_order_relaxed)};
+}
+
+void Engine::maybe_snapshot(Shard& shard, uint64_t applied) {
+    if (!shard.journal) return;
+    bool requested = shard.snapshot_requested.load(memory_order_acquire);
+    bool due = config.snapshot.every && applied - shard.snapshot_sequence >= config.snapshot.every;
+    if (!(requested || due) || shard.snapshot_running.load(memory_order_acquire)) return;
+    shard.snapshot_requested.store(false, memory_order_relaxed);
+    take_snapshot(shard, applied);
+}
+
+void Engine::take_snapshot(Shard& shard, uint64_t sequence) {
+    // Paths are built before forking: the child must not allocate
+    string path = snapshot_path(config.journal.dir, shard.index, sequence);
+    string tmp_path = path + ".tmp";
+    auto t0 = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) _exit(write_snapshot(shard, sequence, tmp_path.c_str(), path.c_str()) ? 0 : 1);
+    uint64_t us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - t0).count();
+    for (uint64_t seen = max_fork_us.load(memory_order_relaxed);
+         us > seen && !max_fork_us.compare_exchange_weak(seen, us, memory_order_relaxed);) {}
+    if (pid < 0) {
+        LOG_ERROR("Snapshot of shard {} failed: cannot fork", shard.index);
+        snapshots_failed.fetch_add(1, memory_order_release);
+        return;
+    }
+    shard.snapshot_sequence = sequence;
+    shard.snapshot_running.store(true, memory_order_release);
+    {
+        lock_guard<mutex> lock(reaper_mutex);
+        pending_snapshots.push_back({pid, shard.index, sequence});
+    }
+    reaper_cv.notify_one();
+}
+
+bool Engine::write_snapshot(const Shard& shard, uint64_t sequence, const char* tmp_path, const char* path) {
+    int fd = ::open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    SnapshotWriter writer(fd);
+    SnapshotHeader header{};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.order_size = sizeof(SnapshotOrder);
+    header.shard = shard.index;
+    header.sequence = sequence;
+    header.tick_size = config.book.tick_size;
+    for (size_t symbol = 0; symbol < books.size(); ++symbol) header.books += shard_of(symbol) == shard.index;
+    bool ok = writer.put(&header, sizeof(header));
+    for (size_t symbol = 0; symbol < books.size() && ok; ++symbol) {
+        if (shard_of(symbol) != shard.index) continue;
+        Book& book = *books[symbol];
+        SnapshotBookHeader b{};
+        b.symbol = uint32_t(symbol);
+        b.last_trade = book.last_trade_price().ticks;
+        b.orders = book.orders.size();
+        ok = writer.put(&b, sizeof(b));
+        book.for_each_order([&](const Order& o, uint64_t arrival) { ok = ok && writer.add(o, arrival); });
+    }
+    ok = ok && writer.finish() && ::fdatasync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    return ok && ::rename(tmp_path, path) == 0;
+}
+
+void Engine::run_reaper() {
+    while (true) {
+        PendingSnapshot p;
+        {
+            unique_lock<mutex> lock(reaper_mutex);
+            reaper_cv.wait(lock, [&] { return !pending_snapshots.empty() || reaper_stopping; });
+            if (pending_snapshots.empty()) return;
+            p = pending_snapshots.front();
+            pending_snapshots.pop_front();
+        }
+        int status = 0;
+        pid_t r;
+        do {
+            r = waitpid(p.pid, &status, 0);
+        } while (r < 0 && errno == EINTR);
+        const string& dir = config.journal.dir;
+        if (r == p.pid && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            // Make the rename durable, then drop snapshots and journal segments no longer needed
+            int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+            if (dir_fd >= 0) {
+                ::fsync(dir_fd);
+                ::close(dir_fd);
+            }
+            vector<pair<uint64_t, string>> snapshots = list_snapshots(dir, p.shard);
+            size_t keep = max<size_t>(1, config.snapshot.keep);
+            for (size_t i = 0; i + keep < snapshots.size(); ++i) {
+                error_code ec;
+                filesystem::remove(snapshots[i].second, ec);
+            }
+            if (snapshots.size() >= keep) Journal::prune(dir, p.shard, snapshots[snapshots.size() - keep].first);
+            snapshots_written.fetch_add(1, memory_order_release);
+            LOG_INFO("Snapshot of shard {} at sequence {} written", p.shard, p.sequence);
+        } else {
+            error_code ec;
+            filesystem::remove(snapshot_path(dir, p.shard, p.sequence) + ".tmp", ec);
+            snapshots_failed.fetch_add(1, memory_order_release);
+            LOG_ERROR("Snapshot of shard {} at sequence {} failed", p.shard, p.sequence);
+        }
+        shard_list[p.shard]->snapshot_running.store(false, memory_order_release);
+    }
+}
+
+size_t Engine::register_producer() {
+    // All shards hand out lanes in the same order, so one id names the lane in each
+    lock_guard<mutex> lock(register_mutex);
+    size_t id = 0;
+    for (auto& shard : shard_list) id = shard->ingress.register_producer();
+    return id;
+}
+
+bool Engine::try_submit(size_t producer, const OrderMessage& message) {
+    Shard& shard = *shard_list[shard_of(message.order.symbol_id)];
+    if (!shard.ingress.try_push(producer, message)) return false;
+    shard.waiter.notify();
+    return true;
+}
+
+PushResult Engine::submit(size_t producer, const OrderMessage& message) {
+    Shard& shard = *shard_list[shard_of(message.order.symbol_id)];
+    PushResult result = shard.ingress.push(producer, message);
+    if (result == PushResult::ACCEPTED) shard.waiter.notify();
+    return result;
+}
+
+uint64_t Engine::matched() const {
+    uint64_t total = 0;
+    for (auto& shard : shard_list) total += shard->processed.load(memory_order_relaxed);
+    return total;
+}
+
+IngressStats Engine::ingress_stats() const {
+    IngressStats total;
+    for (auto& shard : shard_list) {
+        IngressStats s = shard->ingress.stats();
+        total.depth += s.depth;
+        total.max_depth = max(total.max_depth, s.max_depth);
+        total.accepted += s.accepted;
+        total.rejected += s.rejected;
+        total.shed += s.shed;
+    }
+    return total;
+}
+
+JournalStats Engine::journal_stats() const {
+    JournalStats total = closed_journals;
+    for (auto& shard : shard_list) {
+        if (!shard->journal) continue;
+        JournalStats s = shard->journal->stats();
+        total.records += s.records;
+        total.groups += s.groups;
+        total.bytes += s.bytes;
+        total.segments += s.segments;
+    }
+    return total;
+}
+
+TradeTapeStats Engine::tape_stats() const {
+    TradeTapeStats total = closed_tapes;
+    for (auto& shard : shard_list) {
+        if (!shard->tape) continue;
+        TradeTapeStats s = shard->tape->stats();
+        total.records += s.records;
+        total.writes += s.writes;
+        total.bytes += s.bytes;
+        total.files += s.files;
+        total.full += s.full;
+    }
+    return total;
+}
+
+const char* Engine::check(const OrderMessage& message) const {
+    const Order& o = message.order;
+    if (o.symbol_id >= books.size()) return "unknown symbol";
+    if (message.type == MessageType::CANCEL) return nullptr;
+    if (o.quantity <= 0) return "non-positive quantity";
+    if (o.quantity > config.max_order_qty) return "quantity above risk limit";
+    bool priced = message.type == MessageType::MODIFY || o.type == OrderType::LIMIT || o.type == OrderType::STOP_LIMIT;
+    if (priced && o.price <= Price(0)) return "non-positive price";
+    bool stop = message.type == MessageType::NEW && (o.type == OrderType::STOP || o.type == OrderType::STOP_LIMIT);
+    if (stop && o.stop_price <= Price(0)) return "non-positive stop price";
+    return nullptr;
+}
+
+// Shard i alone is engine thread i; pipelined shard i has threads 4i .. 4i+3
+int Engine::cpu_of(const Shard& shard, size_t stage) const {
+    return cpu_for(config.shard_cpus, config.pipelined ? shard.index * 4 + stage : shard.index);
+}
+
+void Engine::publish_views(const vector<uint32_t>& symbols, BookSnapshot& scratch) {
+    if (!config.publish_snapshots) return;
+    for (uint32_t symbol : symbols) {
+        books[symbol]->snapshot(scratch);
+        views[symbol]->store(scratch);
+    }
+}
+
+void Engine::run_shard(Shard& shard) {
+    vector<OrderMessage> batch(config.batch, OrderMessage::cancel(0, 0));
+    vector<const char*> rejects(config.batch);
+    vector<uint32_t> touched;
+    touched.reserve(config.batch);
+    vector<uint64_t> touched_pass(books.size(), 0);
+    uint64_t pass = 0;
+    auto snapshot = make_unique<BookSnapshot>();
+    int cpu = cpu_of(shard, 0);
+    if (!pin_current_thread(cpu)) LOG_WARN("Could not pin matcher shard to CPU {}", cpu);
+    auto has_work = [&] {
+        return !shard.ingress.empty() || !running_.load(memory_order_acquire) ||
+               shard.snapshot_requested.load(memory_order_acquire);
+    };
+    unsigned idle_polls = 0;
+
+    while (true) {
+        auto t0 = chrono::high_resolution_clock::now();
+        size_t n = shard.ingress.pop_batch(batch, config.batch);
+        if (n == 0) {
+            if (running_.load(memory_order_acquire)) {
+                maybe_snapshot(shard, shard.sequence);
+                shard.waiter.idle(idle_polls, has_work);
+                if (idle_polls < (1u << 30)) ++idle_polls;
+                continue;
+            }
+            // Stopping: everything submitted before stop() is visible now
+            n = shard.ingress.pop_batch(batch, config.batch);
+            if (n == 0) break;
+        }
+        idle_polls = 0;
+        auto t1 = chrono::high_resolution_clock::now();
+        if (config.pop_latency) {
+            double pop_micros = chrono::duration<double, micro>(t1 - t0).count() / n;
+            config.pop_latency->add(pop_micros, n);
+        }
+
+        // Number (and journal) the accepted messages before any of them is matched
+        for (size_t i = 0; i < n; ++i) {
+            rejects[i] = check(batch[i]);
+            if (rejects[i]) continue;
+            ++shard.sequence;
+            if (shard.journal) shard.journal->append(shard.sequence, batch[i]);
+        }
+        if (shard.journal) shard.journal->commit(shard.sequence);
+
+        ++pass;
+        touched.clear();
+        auto prev = t1;
+        for (size_t i = 0; i < n; ++i) {
+            Order& incoming = batch[i].order;
+            uint32_t symbol = incoming.symbol_id;
+            if (rejects[i]) {
+                LOG_WARN("Order {} rejected: {}", incoming.order_id, rejects[i]);
+                continue;
+            }
+            switch (batch[i].type) {
+                case MessageType::NEW:
+                    shard.matcher.match_order(incoming, *books[symbol]);
+                    if (config.on_matched) config.on_matched(incoming);
+                    break;
+                case MessageType::CANCEL:
+                    books[symbol]->cancel_order(incoming.order_id);
+                    break;
+                case MessageType::MODIFY:
+                    books[symbol]->modify_order(incoming.order_id, incoming.price, incoming.quantity);
+                    break;
+            }
+            if (touched_pass[symbol] != pass) {
+                touched_pass[symbol] = pass;
+                touched.push_back(symbol);
+            }
+            if (config.match_latency) {
+                auto now = chrono::high_resolution_clock::now();
+                config.match_latency->add(chrono::duration<double, micro>(now - prev).count());
+                prev = now;
+            }
+        }
+        publish_views(touched, *snapshot);
+        shard.processed.fetch_add(n, memory_order_relaxed);
+        maybe_snapshot(shard, shard.sequence);
+    }
+}
+
+void Engine::run_validate(Shard& shard) {
+    Pipeline& p = *shard.pipeline;
+    int cpu = cpu_of(shard, 0);
+    if (!pin_current_thread(cpu)) LOG_WARN("Could not pin validate stage to CPU {}", cpu);
+    auto has_work = [&] { return !shard.ingress.empty() || !running_.load(memory_order_acquire); };
+    unsigned idle_polls = 0;
+    uint64_t next = 0;
+
+    while (true) {
+        bool stopping = !running_.load(memory_order_acquire);
+        // A slot is free once the publish stage is done with the event in it
+        uint64_t limit = min<uint64_t>(p.published.value.load(memory_order_acquire) + Pipeline::SIZE, next + config.batch);
+        uint64_t start = next;
+        auto t0 = chrono::high_resolution_clock::now();
+        while (next < limit && shard.ingress.try_pop(p.at(next).message)) {
+            PipelineEvent& event = p.at(next++);
+            event.received_ns = now_ns();
+            event.reject_reason = check(event.message);
+        }
+        if (next != start) {
+            p.validated.value.store(next, memory_order_release);
+            if (config.pop_latency) {
+                double pop_micros = chrono::duration<double, micro>(chrono::high_resolution_clock::now() - t0).count();
+                config.pop_latency->add(pop_micros / (next - start), next - start);
+            }
+            idle_polls = 0;
+            continue;
+        }
+        // Nothing taken although there was room: the ingress is empty
+        if (stopping && next < limit) break;
+        shard.waiter.idle(idle_polls, has_work);
+        if (idle_polls < (1u << 30)) ++idle_polls;
+    }
+    p.validated.done.store(true, memory_order_release);
+}
+
+template <typename Process, typename Poll>
+void Engine::run_stage(Shard& shard, StageCursor& upstream, StageCursor& own, Process&& process, Poll&& poll) {
+    // Nobody notifies a downstream stage, so it polls rather than parks
+    IdleWaiter waiter(config.wait == WaitStrategy::SPIN ? WaitStrategy::SPIN : WaitStrategy::SPIN_YIELD, config.spin_polls);
+    auto never = [] { return false; };
+    unsigned idle_polls = 0;
+    uint64_t next = 0;
+
+    while (true) {
+        poll();
+        bool upstream_done = upstream.done.load(memory_order_acquire);
+        uint64_t available = upstream.value.load(memory_order_acquire);
+        if (next == available) {
+            if (upstream_done) break;
+            waiter.idle(idle_polls, never);
+            if (idle_polls < (1u << 30)) ++idle_polls;
+            continue;
+        }
+        idle_polls = 0;
+        available = min<uint64_t>(available, next + config.batch);
+        process(next, available);
+        next = available;
+        own.value.store(next, memory_order_release);
+    }
+    poll();
+    own.done.store(true, memory_order_release);
+}
+
+void Engine::run_sequence(Shard& shard) {
+    Pipeline& p = *shard.pipeline;
+    int cpu = cpu_of(shard, 1);
+    if (!pin_current_thread(cpu)) LOG_WARN("Could not pin sequence stage to CPU {}", cpu);
+    run_stage(shard, p.validated, p.sequenced, [&](uint64_t first, uint64_t last) {
+        for (uint64_t i = first; i < last; ++i) {
+            PipelineEvent& event = p.at(i);
+            if (event.reject_reason) continue;
+            event.sequence = ++shard.sequence;
+            if (shard.journal) shard.journal->append(event.sequence, event.message);
+        }
+        // The match stage only sees the batch once this returns
+        if (shard.journal) shard.journal->commit(shard.sequence);
+    }, [] {});
+}
+
+void Engine::run_match(Shard& shard, uint64_t applied) {
+    Pipeline& p = *shard.pipeline;
+    int cpu = cpu_of(shard, 2);
+    if (!pin_current_thread(cpu)) LOG_WARN("Could not pin match stage to CPU {}", cpu);
+    vector<uint32_t> touched;
+    touched.reserve(config.batch);
+    vector<uint64_t> touched_pass(books.size(), 0);
+    uint64_t pass = 0;
+    auto snapshot = make_unique<BookSnapshot>();
+
+    run_stage(shard, p.sequenced, p.matched, [&](uint64_t first, uint64_t last) {
+        ++pass;
+        touched.clear();
+        auto prev = chrono::high_resolution_clock::now();
+        for (uint64_t i = first; i < last; ++i) {
+            PipelineEvent& event = p.at(i);
+            if (event.reject_reason) continue;
+            applied = event.sequence;
+            Order& incoming = event.message.order;
+            uint32_t symbol = incoming.symbol_id;
+            switch (event.message.type) {
+                case MessageType::NEW:
+                    Matcher::match_order(incoming, *books[symbol], [&](int maker_id, Price price, int qty) {
+                        FillEvent fill{event.sequence, incoming.order_id, maker_id, symbol, incoming.side, price, qty, event.received_ns};
+                        while (!p.fills.try_push(fill)) this_thread::yield();   // the publish stage drains it
+                    });
+                    break;
+                case MessageType::CANCEL:
+                    books[symbol]->cancel_order(incoming.order_id);
+                    break;
+                case MessageType::MODIFY:
+                    books[symbol]->modify_order(incoming.order_id, incoming.price, incoming.quantity);
+                    break;
+            }
+            if (touched_pass[symbol] != pass) {
+                touched_pass[symbol] = pass;
+                touched.push_back(symbol);
+            }
+            if (config.match_latency) {
+                auto now = chrono::high_resolution_clock::now();
+                config.match_latency->add(chrono::duration<double, micro>(now - prev).count());
+                prev = now;
+            }
+        }
+        publish_views(touched, *snapshot);
+    }, [&] { if (running_.load(memory_order_relaxed)) maybe_snapshot(shard, applied); });   // Between batches, a consistent cut
+}
+
+void Engine::run_publish(Shard& shard) {
+    Pipeline& p = *shard.pipeline;
+    int cpu = cpu_of(shard, 3);
+    if (!pin_current_thread(cpu)) LOG_WARN("Could not pin publish stage to CPU {}", cpu);
+    // Fills are drained as they arrive rather than per event, so one order sweeping
+    // more levels than the fill ring holds cannot stall the match stage
+    auto drain_fills = [&] {
+        while (FillEvent* fill = p.fills.front()) {
+            double price = fill->price.to_double(config.book.tick_size);
+            LOG_INFO("Matched Order {} with Order {} at Price {} for Quantity {}",
+                     fill->taker_id, fill->maker_id, price, fill->quantity);
+            if (shard.tape) {
+                int64_t timestamp = chrono::system_clock::now().time_since_epoch() / chrono::nanoseconds(1);
+                shard.tape->append(fill->symbol_id, fill->taker_side, fill->taker_id, fill->maker_id, fill->price,
+                                   fill->quantity, timestamp, now_ns() - fill->received_ns);
+            }
+            p.fills.pop();
+        }
+    };
+    run_stage(shard, p.matched, p.published, [&](uint64_t first, uint64_t last) {
+        for (uint64_t i = first; i < last; ++i) {
+            PipelineEvent& event = p.at(i);
+            if (event.reject_reason) {
+                LOG_WARN("Order {} rejected: {}", event.message.order.order_id, event.reject_reason);
+            } else if (event.message.type == MessageType::NEW && config.on_matched) {
+                config.on_matched(event.message.order);
+            }
+        }
+        shard.processed.fetch_add(last - first, memory_order_relaxed);
+    }, drain_fills);
+}
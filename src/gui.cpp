@@ -1,13 +1,15 @@
 #include "gui.hpp"
 #include "latency_metrics.hpp"
-#include "thread_safe_queue.hpp"
 #include <imgui.h>
 #include <vector>
 #include <algorithm>
 
 extern LatencyMetrics queue_push_latency, queue_pop_latency, match_latency, gui_frame_latency;
 
-void run_gui(OrderBook& book) {
+void run_gui(Engine& engine) {
+    static int symbol = 0;
+    static BookSnapshot view;
+    engine.snapshot(symbol, view);
 
     // Make the window take up the entire viewport
     ImGui::SetNextWindowPos(ImVec2(0, 0));
@@ -24,8 +26,15 @@ void run_gui(OrderBook& book) {
     static char* order_types[] = { (char*)"Limit", (char*)"Market", (char*)"Stop", (char*)"Stop-Limit" };
     static char* sides[] = { (char*)"Buy", (char*)"Sell" };
 
-    ImGui::BeginChild("OrderEntry", ImVec2(0, 110), true);
+    static int cancel_id = 0;
+    static bool last_rejected = false;
+    // The GUI thread is a producer of its own
+    static size_t gui_producer = engine.register_producer();
+
+    ImGui::BeginChild("OrderEntry", ImVec2(0, 160), true);
     ImGui::Text("Order Entry");
+    // The selected symbol is both where orders go and which book is shown below
+    if (ImGui::InputInt("Symbol", &symbol)) symbol = std::clamp(symbol, 0, (int)engine.symbols() - 1);
     ImGui::Combo("Order Type", &order_type, order_types, 4);
     ImGui::Combo("Side", &side, sides, 2);
     if (order_type == 0 || order_type == 3) // Limit or Stop-Limit
@@ -41,12 +50,21 @@ void run_gui(OrderBook& book) {
         if (order_type == 1) t = OrderType::MARKET;
         if (order_type == 2) t = OrderType::STOP;
         if (order_type == 3) t = OrderType::STOP_LIMIT;
+        // Convert the decimal inputs to ticks of the book's instrument
+        Price p = Price::from_double(price, view.tick_size);
+        Price sp = Price::from_double(stop_price, view.tick_size);
         Order o = (t == OrderType::STOP || t == OrderType::STOP_LIMIT)
-            ? Order(next_order_id++, ImGui::GetTime(), s, t, price, quantity, stop_price)
-            : Order(next_order_id++, ImGui::GetTime(), s, t, price, quantity);
-        extern ThreadSafeQueue<Order> order_queue;
-        order_queue.push(o);
+            ? Order(next_order_id++, ImGui::GetTime(), s, t, p, quantity, sp)
+            : Order(next_order_id++, ImGui::GetTime(), s, t, p, quantity);
+        o.symbol_id = symbol;
+        last_rejected = engine.submit(gui_producer, o) == PushResult::REJECTED;
+    }
+    ImGui::InputInt("Order ID", &cancel_id);
+    ImGui::SameLine();
+    if (ImGui::Button("Cancel Order")) {
+        last_rejected = engine.submit(gui_producer, OrderMessage::cancel(symbol, cancel_id)) == PushResult::REJECTED;
     }
+    if (last_rejected) ImGui::Text("Last request rejected: ingress full");
     ImGui::EndChild();
 
     ImGui::Text("Live Bid/Ask Depth");
@@ -56,29 +74,38 @@ void run_gui(OrderBook& book) {
     ImGui::BeginChild("MetricsChild", ImVec2(0, 250), true, ImGuiWindowFlags_NoMove);
     ImGui::Text("Performance Metrics (microseconds)");
     ImGui::Columns(2, nullptr, false);
-    ImGui::Text("Queue Push"); ImGui::NextColumn();
-    ImGui::Text("Avg: %.2f, Min: %.2f, Max: %.2f", queue_push_latency.avg(), queue_push_latency.min(), queue_push_latency.max()); ImGui::NextColumn();
-    ImGui::Text("Queue Pop"); ImGui::NextColumn();
-    ImGui::Text("Avg: %.2f, Min: %.2f, Max: %.2f", queue_pop_latency.avg(), queue_pop_latency.min(), queue_pop_latency.max()); ImGui::NextColumn();
-    ImGui::Text("Order Match"); ImGui::NextColumn();
-    ImGui::Text("Avg: %.2f, Min: %.2f, Max: %.2f", match_latency.avg(), match_latency.min(), match_latency.max()); ImGui::NextColumn();
-    ImGui::Text("GUI Frame"); ImGui::NextColumn();
-    ImGui::Text("Avg: %.2f, Min: %.2f, Max: %.2f", gui_frame_latency.avg(), gui_frame_latency.min(), gui_frame_latency.max()); ImGui::NextColumn();
+    // One merge per metric per frame; the cost does not grow with the sample count
+    auto row = [](const char* label, const LatencyMetrics& m) {
+        LatencySummary l = m.summary();
+        ImGui::Text("%s", label); ImGui::NextColumn();
+        ImGui::Text("p50: %.2f, p90: %.2f, p99: %.2f, p99.9: %.2f, p99.99: %.2f, Max: %.2f (n=%llu)",
+                    l.p50, l.p90, l.p99, l.p999, l.p9999, l.max, (unsigned long long)l.count);
+        ImGui::NextColumn();
+    };
+    row("Queue Push", queue_push_latency);
+    row("Queue Pop", queue_pop_latency);
+    row("Order Match", match_latency);
+    row("GUI Frame", gui_frame_latency);
+    IngressStats ingress = engine.ingress_stats();
+    ImGui::Text("Ingress"); ImGui::NextColumn();
+    ImGui::Text("Depth: %llu (max %llu), Rejected: %llu, Shed: %llu", (unsigned long long)ingress.depth,
+                (unsigned long long)ingress.max_depth, (unsigned long long)ingress.rejected, (unsigned long long)ingress.shed);
+    ImGui::NextColumn();
     ImGui::Columns(1);
     ImGui::Spacing();
-    // Plot latency history
-    auto plot = [](const char* label, LatencyMetrics& m) {
-        auto samples = m.get_samples();
-        if (!samples.empty()) {
-            std::vector<float> float_samples(samples.begin(), samples.end());
+    // Plot p99 per time slice of the window
+    auto plot = [](const char* label, const LatencyMetrics& m) {
+        auto p99 = m.history(0.99);
+        if (!p99.empty()) {
+            std::vector<float> float_samples(p99.begin(), p99.end());
             float max_val = *std::max_element(float_samples.begin(), float_samples.end());
             ImGui::PlotLines(label, float_samples.data(), float_samples.size(), 0, nullptr, 0.0f, max_val, ImVec2(0, 60));
         }
     };
-    plot("Queue Push Latency", queue_push_latency);
-    plot("Queue Pop Latency", queue_pop_latency);
-    plot("Order Match Latency", match_latency);
-    plot("GUI Frame Latency", gui_frame_latency);
+    plot("Queue Push p99", queue_push_latency);
+    plot("Queue Pop p99", queue_pop_latency);
+    plot("Order Match p99", match_latency);
+    plot("GUI Frame p99", gui_frame_latency);
     ImGui::Separator();
     ImGui::Spacing();
     ImGui::EndChild(); // Correctly close the metrics child window
@@ -94,17 +121,11 @@ void run_gui(OrderBook& book) {
     ImGui::Columns(2, nullptr, false);
     ImGui::Text("Price"); ImGui::NextColumn();
     ImGui::Text("Size"); ImGui::NextColumn();
-    std::vector<std::pair<double, int>> bids;
-    for (const auto& [price, queue] : book.buy_book) {
-        int qty = 0;
-        std::queue<Order> q = queue;
-        while (!q.empty()) { qty += q.front().quantity; q.pop(); }
-        bids.emplace_back(price, qty);
-    }
-    std::sort(bids.begin(), bids.end(), std::greater<>());
-    for (const auto& [price, qty] : bids) {
-        ImGui::Text("%.2f", price); ImGui::NextColumn();
-        ImGui::Text("%d", qty); ImGui::NextColumn();
+    // Level totals come straight from the book's per-level aggregates
+    for (size_t i = 0; i < view.bid_levels; ++i) {
+        const DepthLevel& level = view.bids[i];
+        ImGui::Text("%.2f", level.price.to_double(view.tick_size)); ImGui::NextColumn();
+        ImGui::Text("%lld", (long long)level.quantity); ImGui::NextColumn();
     }
     ImGui::Columns(1);
     ImGui::EndChild();
@@ -117,17 +138,10 @@ void run_gui(OrderBook& book) {
     ImGui::Columns(2, nullptr, false);
     ImGui::Text("Size"); ImGui::NextColumn();
     ImGui::Text("Price"); ImGui::NextColumn();
-    std::vector<std::pair<double, int>> asks;
-    for (const auto& [price, queue] : book.sell_book) {
-        int qty = 0;
-        std::queue<Order> q = queue;
-        while (!q.empty()) { qty += q.front().quantity; q.pop(); }
-        asks.emplace_back(price, qty);
-    }
-    std::sort(asks.begin(), asks.end());
-    for (const auto& [price, qty] : asks) {
-        ImGui::Text("%d", qty); ImGui::NextColumn();
-        ImGui::Text("%.2f", price); ImGui::NextColumn();
+    for (size_t i = 0; i < view.ask_levels; ++i) {
+        const DepthLevel& level = view.asks[i];
+        ImGui::Text("%lld", (long long)level.quantity); ImGui::NextColumn();
+        ImGui::Text("%.2f", level.price.to_double(view.tick_size)); ImGui::NextColumn();
     }
     ImGui::Columns(1);
     ImGui::EndChild();
@@ -137,15 +151,15 @@ void run_gui(OrderBook& book) {
     ImGui::Separator();
     ImGui::Text("Pending Stop/Stop-Limit Orders:");
     ImGui::BeginChild("PendingStops", ImVec2(0, 80), true);
-    for (const auto& o : book.stop_orders) {
-        ImGui::Text("ID: %d | %s %s | Qty: %d | Stop: %.2f | Limit: %.2f | Triggered: %s",
+    for (size_t i = 0; i < view.stop_count; ++i) {
+        const PendingStop& o = view.stops[i];
+        ImGui::Text("ID: %d | %s %s | Qty: %d | Stop: %.2f | Limit: %.2f",
             o.order_id,
             o.side == Side::BUY ? "Buy" : "Sell",
             o.type == OrderType::STOP ? "Stop" : "Stop-Limit",
             o.quantity,
-            o.stop_price,
-            o.type == OrderType::STOP_LIMIT ? o.price : 0.0,
-            o.triggered ? "Yes" : "No");
+            o.stop_price.to_double(view.tick_size),
+            o.type == OrderType::STOP_LIMIT ? o.limit_price.to_double(view.tick_size) : 0.0);
     }
     ImGui::EndChild();
 
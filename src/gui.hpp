@@ -1,5 +1,5 @@
 #pragma once
-#include "order_book.hpp"
+#include "engine.hpp"
 
-// Initializes and runs the ImGui dashboard
-void run_gui(OrderBook& book);
+// Draws the ImGui dashboard from the published snapshot of the selected symbol's book
+void run_gui(Engine& engine);
@@ -0,0 +1,232 @@
+#include "journal.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+constexpr char JOURNAL_MAGIC[8] = {'L', 'O', 'B', 'J', 'R', 'N', 'L', '1'};
+constexpr uint32_t JOURNAL_VERSION = 1;
+
+[[noreturn]] static void fatal(const char* what) {
+    fprintf(stderr, "journal: %s failed: %s\n", what, strerror(errno));
+    abort();
+}
+
+static string segment_path(const string& dir, size_t shard, uint64_t first_sequence) {
+    char name[64];
+    snprintf(name, sizeof(name), "shard%zu-%020" PRIu64 ".wal", shard, first_sequence);
+    return dir + "/" + name;
+}
+
+// Segments of a shard as (first sequence, path), oldest first
+static vector<pair<uint64_t, string>> list_segments(const string& dir, size_t shard) {
+    vector<pair<uint64_t, string>> segments;
+    string prefix = "shard" + to_string(shard) + "-";
+    error_code ec;
+    for (const auto& entry : filesystem::directory_iterator(dir, ec)) {
+        string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) != 0 || entry.path().extension() != ".wal") continue;
+        segments.emplace_back(stoull(name.substr(prefix.size())), entry.path().string());
+    }
+    sort(segments.begin(), segments.end());
+    return segments;
+}
+
+void JournalConfig::validate() const {
+    if (segment_bytes < sizeof(JournalSegmentHeader) + sizeof(JournalRecord))
+        throw invalid_argument("journal segment too small");
+}
+
+JournalConfig JournalConfig::from_env() {
+    JournalConfig config;
+    if (const char* v = getenv("LOB_JOURNAL_DIR")) config.dir = v;
+    if (const char* v = getenv("LOB_DURABILITY")) config.durability = parse_durability(v);
+    if (const char* v = getenv("LOB_JOURNAL_SEGMENT_MB")) {
+        size_t used = 0;
+        unsigned long mb = 0;
+        try { mb = stoul(v, &used); } catch (const exception&) {}
+        if (used == 0 || v[used] != '\0' || mb == 0) throw invalid_argument(string("bad LOB_JOURNAL_SEGMENT_MB: ") + v);
+        config.segment_bytes = size_t(mb) << 20;
+    }
+    config.validate();
+    return config;
+}
+
+Journal::Journal(const JournalConfig& config_, size_t shard_, uint64_t next_sequence)
+    : config(config_), shard(shard_), group(GROUP_RECORDS) {
+    config.validate();
+    filesystem::create_directories(config.dir);
+    dir_fd = ::open(config.dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0) throw runtime_error("cannot open journal directory " + config.dir + ": " + strerror(errno));
+    durable_.store(next_sequence - 1, memory_order_relaxed);
+    try {
+        // Segments from `next_sequence` on hold records past the recovery point (after a torn
+        // record, a gap, or with recovery off) and would sort among ours on the next recovery
+        for (const auto& [first, path] : list_segments(config.dir, shard)) {
+            error_code ec;
+            if (first >= next_sequence && !filesystem::remove(path, ec))
+                throw runtime_error("cannot remove stale journal segment " + path + ": " + ec.message());
+        }
+        open_segment(next_sequence);
+    } catch (...) {
+        ::close(dir_fd);
+        throw;
+    }
+    writer = thread([this] { run(); });
+}
+
+void Journal::close() {
+    if (!writer.joinable()) return;
+    stopping.store(true, memory_order_release);
+    waiter.wake();
+    writer.join();
+    close_segment();
+    ::close(dir_fd);
+    dir_fd = -1;
+}
+
+void Journal::commit(uint64_t sequence) {
+    waiter.notify();
+    if (config.durability != Durability::SYNC) return;
+    for (uint64_t d = durable(); d < sequence; d = durable()) durable_.wait(d, memory_order_acquire);
+}
+
+JournalStats Journal::stats() const {
+    return {records.load(memory_order_relaxed), groups.load(memory_order_relaxed),
+            bytes.load(memory_order_relaxed), segments.load(memory_order_relaxed)};
+}
+
+void Journal::run() {
+    auto has_work = [&] { return !ring.empty() || stopping.load(memory_order_acquire); };
+    unsigned idle_polls = 0;
+    while (true) {
+        size_t n = 0;
+        while (n < GROUP_RECORDS) {
+            JournalRecord* r = ring.front();
+            if (!r) break;
+            group[n++] = *r;
+            ring.pop();
+        }
+        if (n > 0) {
+            write_group(n);
+            idle_polls = 0;
+            continue;
+        }
+        // Appends before the stop request are in the ring by now
+        if (stopping.load(memory_order_acquire) && ring.empty()) break;
+        waiter.idle(idle_polls, has_work);
+        if (idle_polls < (1u << 30)) ++idle_polls;
+    }
+}
+
+void Journal::write_group(size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        size_t room = (config.segment_bytes - offset) / sizeof(JournalRecord);
+        if (room == 0) {
+            close_segment();
+            open_segment(group[done].sequence);
+            continue;
+        }
+        size_t count = min(room, n - done);
+        const char* p = reinterpret_cast<const char*>(&group[done]);
+        size_t left = count * sizeof(JournalRecord);
+        while (left > 0) {
+            ssize_t w = ::pwrite(fd, p, left, offset);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                fatal("write");
+            }
+            p += w;
+            left -= w;
+            offset += w;
+        }
+        done += count;
+    }
+    if (config.durability != Durability::NONE) sync(fd);
+    records.fetch_add(n, memory_order_relaxed);
+    groups.fetch_add(1, memory_order_relaxed);
+    bytes.fetch_add(n * sizeof(JournalRecord), memory_order_relaxed);
+    durable_.store(group[n - 1].sequence, memory_order_release);
+    if (config.durability == Durability::SYNC) durable_.notify_all();
+}
+
+void Journal::open_segment(uint64_t first_sequence) {
+    string path = segment_path(config.dir, shard, first_sequence);
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw runtime_error("cannot create journal segment " + path + ": " + strerror(errno));
+    if (int err = posix_fallocate(fd, 0, config.segment_bytes)) {
+        ::close(fd);
+        throw runtime_error("cannot preallocate journal segment " + path + ": " + strerror(err));
+    }
+    JournalSegmentHeader header{};
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.record_size = sizeof(JournalRecord);
+    header.shard = shard;
+    header.first_sequence = first_sequence;
+    if (::pwrite(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header))) {
+        ::close(fd);
+        throw runtime_error("cannot write journal segment " + path + ": " + strerror(errno));
+    }
+    offset = sizeof(header);
+    if (config.durability != Durability::NONE) {
+        sync(fd);
+        sync(dir_fd);   // The new directory entry
+    }
+    segments.fetch_add(1, memory_order_relaxed);
+}
+
+void Journal::close_segment() {
+    if (fd < 0) return;
+    if (config.durability != Durability::NONE) sync(fd);
+    ::close(fd);
+    fd = -1;
+}
+
+void Journal::sync(int file) {
+    if (::fdatasync(file) != 0) fatal("fdatasync");
+}
+
+uint64_t Journal::recover(const string& dir, size_t shard, uint64_t after,
+                          const function<void(uint64_t, const OrderMessage&)>& apply) {
+    vector<pair<uint64_t, string>> segments = list_segments(dir, shard);
+    uint64_t last = after;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        // Skip segments wholly covered by `after`
+        if (i + 1 < segments.size() && segments[i + 1].first <= after + 1) continue;
+        MappedFile file(segments[i].second);
+        JournalSegmentHeader header;
+        if (file.size() < sizeof(header)) throw runtime_error("truncated journal segment " + segments[i].second);
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 || header.version != JOURNAL_VERSION ||
+            header.record_size != sizeof(JournalRecord) || header.shard != shard) {
+            throw runtime_error("bad journal segment header in " + segments[i].second);
+        }
+        if (header.first_sequence > last + 1) break;   // A gap: later records cannot be applied
+        const JournalRecord* r = reinterpret_cast<const JournalRecord*>(file.data() + sizeof(header));
+        const JournalRecord* end = r + (file.size() - sizeof(header)) / sizeof(JournalRecord);
+        uint64_t expected = header.first_sequence;
+        for (; r != end; ++r, ++expected) {
+            if (r->sequence != expected || r->checksum != checksum(*r)) break;   // Unwritten or torn: end of segment
+            if (r->sequence <= last) continue;
+            apply(r->sequence, to_message(r->event));
+            last = r->sequence;
+        }
+    }
+    return last;
+}
+
+void Journal::prune(const string& dir, size_t shard, uint64_t sequence) {
+    vector<pair<uint64_t, string>> segments = list_segments(dir, shard);
+    for (size_t i = 0; i + 1 < segments.size() && segments[i + 1].first <= sequence + 1; ++i) {
+        error_code ec;
+        filesystem::remove(segments[i].second, ec);
+    }
+}
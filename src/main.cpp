@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <vector>
@@ -5,8 +6,12 @@
 #include <chrono>
 #include "order.hpp"
 #include "order_book.hpp"
-#include "matcher.hpp"
-#include "thread_safe_queue.hpp"
+#include "engine.hpp"
+#include "thread_config.hpp"
+#include "csv_replay.hpp"
+#include "event_file.hpp"
+#include "mapped_file.hpp"
+#include "utils/logger.hpp"
 #include "gui.hpp"
 #include <GLFW/glfw3.h> // Include GLFW
 
@@ -18,22 +23,26 @@
 #include "imgui_impl_opengl3.h"
 #include "latency_metrics.hpp"
 
-OrderBook book;
-Matcher matcher;
-ThreadSafeQueue<Order> order_queue;
-std::mutex book_mutex; // Mutex to protect OrderBook
+// Each symbol's book is owned by one shard's matcher thread; the GUI reads published snapshots
+const int NUM_PRODUCERS = 4;
+const int NUM_SYMBOLS = 4;
+const int NUM_SHARDS = 2;
 
 std::atomic<int> global_order_id = 1;
-std::atomic<bool> matcher_done = false; // Flag to indicate matcher thread exit
 
-LatencyMetrics queue_push_latency(500), queue_pop_latency(500), match_latency(500), gui_frame_latency(500);
+// Latency histograms over the last 10 s, in 0.5 s slices
+LatencyMetrics queue_push_latency(std::chrono::seconds(10), 20), queue_pop_latency(std::chrono::seconds(10), 20),
+    match_latency(std::chrono::seconds(10), 20), gui_frame_latency(std::chrono::seconds(10), 20);
 
 // 🧠 Producer: randomly generates orders
-void producer_func(int trader_id) {
+void producer_func(Engine& engine, int trader_id, int cpu) {
+    if (!pin_current_thread(cpu)) std::cerr << "Could not pin producer " << trader_id << " to CPU " << cpu << std::endl;
     std::default_random_engine rng(std::random_device{}());
     std::uniform_int_distribution<int> qty_dist(1, 50);
     std::uniform_real_distribution<double> price_dist(99.0, 101.0);
     std::uniform_int_distribution<int> side_dist(0, 1);
+    std::uniform_int_distribution<uint32_t> symbol_dist(0, NUM_SYMBOLS - 1);
+    size_t producer = engine.register_producer();
 
     for (int i = 0; i < 10; ++i) {
         // Side side = (side_dist(rng) == 0) ? Side::BUY : Side::SELL;
@@ -43,37 +52,91 @@ void producer_func(int trader_id) {
         double price = 100;
         int qty = 1;
 
-        Order order(global_order_id++, std::chrono::system_clock::now().time_since_epoch().count(), side, OrderType::LIMIT, price, qty);
+        Order order(global_order_id++, std::chrono::system_clock::now().time_since_epoch().count(), side, OrderType::LIMIT, Price::from_double(price, engine.tick_size()), qty);
+        order.symbol_id = symbol_dist(rng);
         auto t0 = std::chrono::high_resolution_clock::now();
-        order_queue.push(order);
+        engine.submit(producer, order);
         auto t1 = std::chrono::high_resolution_clock::now();
         double micros = std::chrono::duration<double, std::micro>(t1 - t0).count();
         queue_push_latency.add(micros);
     }
 }
 
-// ⚙️ Consumer: matches orders
-void matcher_func() {
-    while (true) {
-        auto t0 = std::chrono::high_resolution_clock::now();
-        Order incoming = order_queue.pop();
-        auto t1 = std::chrono::high_resolution_clock::now();
-        double pop_micros = std::chrono::duration<double, std::micro>(t1 - t0).count();
-        queue_pop_latency.add(pop_micros);
-        if (incoming.order_id == -1) break; // Poison pill to exit
-        {
-            auto t2 = std::chrono::high_resolution_clock::now();
-            std::lock_guard<std::mutex> lock(book_mutex);
-            matcher.match_order(incoming, book);
-            auto t3 = std::chrono::high_resolution_clock::now();
-            double match_micros = std::chrono::duration<double, std::micro>(t3 - t2).count();
-            match_latency.add(match_micros);
+// Replays a recorded order flow file (LOB_REPLAY, CSV or binary events) alongside the traders
+void replay_func(Engine& engine, const ReplayConfig& replay_config, const std::atomic<bool>& quit, int cpu) {
+    if (!pin_current_thread(cpu)) std::cerr << "Could not pin replay thread to CPU " << cpu << std::endl;
+    size_t producer = engine.register_producer();
+    try {
+        MappedFile file(replay_config.path);
+        auto submit = [&](const OrderMessage& m) {
+            engine.submit(producer, m);
+            return !quit.load(std::memory_order_relaxed);
+        };
+        ReplayStats stats;
+        if (EventFileReader::is_event_file(file.data(), file.size())) {
+            EventFileReader reader(file.data(), file.size());
+            if (reader.tick_size() != engine.tick_size()) throw std::runtime_error("event file tick size differs from the engine's");
+            stats = replay(reader, submit, replay_config.mode, replay_config.speed);
+        } else {
+            CsvOrderParser parser(file.data(), file.end(), engine.tick_size());
+            stats = replay(parser, submit, replay_config.mode, replay_config.speed);
         }
+        std::cout << "Replayed " << stats.messages << " messages from " << replay_config.path << " ("
+                  << to_string(replay_config.mode) << ") in " << stats.seconds << " s: "
+                  << stats.msgs_per_s() << " msgs/s, " << stats.gb_per_s() << " GB/s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Replay of " << replay_config.path << " failed: " << e.what() << std::endl;
     }
-    matcher_done = true; // Signal done
 }
 
 int main() {
+    // Thread placement, matcher wait strategy, ingress bounds, the replay file, the journal, snapshots and the trade tape come from LOB_* environment variables
+    ThreadConfig threads;
+    IngressConfig ingress;
+    ReplayConfig replay_config;
+    JournalConfig journal;
+    SnapshotConfig snapshot;
+    TradeTapeConfig tape;
+    try {
+        threads = ThreadConfig::from_env();
+        ingress = IngressConfig::from_env();
+        replay_config = ReplayConfig::from_env();
+        journal = JournalConfig::from_env();
+        snapshot = SnapshotConfig::from_env();
+        tape = TradeTapeConfig::from_env();
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Bad configuration: " << e.what() << std::endl;
+        return -1;
+    }
+    if (!pin_current_thread(threads.gui_cpu)) std::cerr << "Could not pin GUI thread to CPU " << threads.gui_cpu << std::endl;
+    if (!pin_thread(Logger::instance().native_handle(), threads.logger_cpu))
+        std::cerr << "Could not pin logger thread to CPU " << threads.logger_cpu << std::endl;
+
+    // Producers (traders and the GUI order form) dispatch straight to the shard owning the symbol
+    EngineConfig config;
+    config.symbols = NUM_SYMBOLS;
+    config.shards = NUM_SHARDS;
+    config.max_producers = NUM_PRODUCERS + 2;   // Traders, the GUI order form and the replay
+    config.ingress = ingress;
+    config.wait = threads.matcher_wait;
+    config.spin_polls = threads.spin_polls;
+    config.shard_cpus = threads.matcher_cpus;
+    config.pipelined = threads.pipelined;
+    config.journal = journal;
+    config.snapshot = snapshot;
+    config.tape = tape;
+    config.pop_latency = &queue_pop_latency;
+    config.match_latency = &match_latency;
+    Engine engine(config);
+
+    // 🧵 Recover the books from the newest snapshot and the journal, then spawn one matcher per shard
+    try {
+        engine.start();
+    } catch (const std::exception& e) {
+        std::cerr << "Cannot start engine: " << e.what() << std::endl;
+        return -1;
+    }
+
     // Initialize ImGui, create a window, and run the GUI loop
     // This is a minimal ImGui+GLFW+OpenGL3 setup for Linux
     // (You must have Dear ImGui, GLFW, and OpenGL3 installed and linked)
@@ -101,14 +164,16 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
 
-    // 🧵 Spawn matcher
-    std::thread matcher_thread(matcher_func);
 
     // 🧵 Spawn traders
-    const int NUM_PRODUCERS = 4;
     std::vector<std::thread> producers;
     for (int i = 0; i < NUM_PRODUCERS; ++i) {
-        producers.emplace_back(producer_func, i + 1);
+        producers.emplace_back(producer_func, std::ref(engine), i + 1, cpu_for(threads.producer_cpus, i));
+    }
+    std::atomic<bool> quit{false};
+    if (!replay_config.path.empty()) {
+        producers.emplace_back(replay_func, std::ref(engine), std::cref(replay_config), std::cref(quit),
+                               cpu_for(threads.producer_cpus, NUM_PRODUCERS));
     }
 
     // --- Main loop ---
@@ -120,14 +185,11 @@ int main() {
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        // Lock book for GUI rendering
-        {
-            std::lock_guard<std::mutex> lock(book_mutex);
-            run_gui(book); // Draw the order book dashboard
-        }
+        // Draw the dashboard from the latest published snapshots; never blocks the matchers
+        run_gui(engine);
 
         // Detect matcher thread exit (done or crash)
-        if (!matcher_crashed && matcher_done.load()) {
+        if (!matcher_crashed && !engine.running()) {
             matcher_crashed = true;
             ImGui::OpenPopup("Matcher Error");
         }
@@ -152,11 +214,11 @@ int main() {
         gui_frame_latency.add(gui_micros);
     }
 
+    quit = true;
     for (auto& t : producers) t.join();
 
-    // Send poison pill to stop matcher (after all producers are done)
-    order_queue.push(Order(-1, 0, Side::BUY, OrderType::LIMIT, 0.0, 0));
-    matcher_thread.join();
+    // Match what the producers submitted, then stop the shard threads
+    engine.stop();
 
     // --- Cleanup ---
     ImGui_ImplOpenGL3_Shutdown();
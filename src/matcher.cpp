@@ -1,72 +1,49 @@
 #include "matcher.hpp"
-#include <iostream>
+#include "utils/logger.hpp"
 #include <chrono>
-#include <fstream>
-#include <sys/stat.h>
 using namespace std;
 
-// Helper to check if file is empty
-bool is_file_empty(const std::string& filename) {
-    struct stat st;
-    if (stat(filename.c_str(), &st) != 0) return true;
-    return st.st_size == 0;
+template <typename L>
+void Matcher::match_order(Order& incoming, BasicOrderBook<L>& book) {
+    std::lock_guard<L> lock(book.book_mutex);
+    match_unlocked(incoming, book);
 }
 
-std::ofstream latency_log;
+template <typename L>
+void Matcher::match_unlocked(Order& incoming, BasicOrderBook<L>& book) {
+    // Latency is measured on the monotonic clock, which NTP adjustments cannot move; the
+    // wall clock only stamps the record. Nothing in the timed region touches a file
+    auto start = tape ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    auto on_fill = [&](int matched_id, Price price, int trade_qty) {
+        LOG_INFO("Matched Order {} with Order {} at Price {} for Quantity {}",
+                 incoming.order_id, matched_id, price.to_double(book.tick_size), trade_qty);
+        if (!tape) return;
+        int64_t latency = (std::chrono::steady_clock::now() - start) / std::chrono::nanoseconds(1);
+        int64_t timestamp = std::chrono::system_clock::now().time_since_epoch() / std::chrono::nanoseconds(1);
+        tape->append(incoming.symbol_id, incoming.side, incoming.order_id, matched_id, price, trade_qty, timestamp, latency);
+    };
+    execute(incoming, book, on_fill);
+}
 
-void Matcher::match_order(Order& incoming, OrderBook& book) {
-    static bool header_written = false;
-    if (!latency_log.is_open()) {
-        latency_log.open("latency.csv", std::ios::app);
-        if (!header_written && is_file_empty("latency.csv")) {
-            latency_log << "incoming_id,matched_id,price,quantity,latency_ns\n";
-            header_written = true;
-        }
-    }
-    auto start = std::chrono::high_resolution_clock::now();
-    std::map<double, std::queue<Order>>* opposite_book;
-    if (incoming.side == Side::BUY) {
-        opposite_book = &book.sell_book;
-    } else {
-        opposite_book = reinterpret_cast<std::map<double, std::queue<Order>>*>(&book.buy_book);
+template <typename L>
+void Matcher::match_batch(std::span<Order> batch, BasicOrderBook<L>& book, std::span<double> latency_ns) {
+    std::lock_guard<L> lock(book.book_mutex);
+    if (latency_ns.empty()) {
+        for (Order& incoming : batch) match_unlocked(incoming, book);
+        return;
     }
-    for (auto it = opposite_book->begin(); it != opposite_book->end() && incoming.quantity > 0; ) {
-        double price_level = it->first;
-        bool price_match = false;
-        if (incoming.type == OrderType::MARKET) price_match = true;
-        else if (incoming.side == Side::BUY) price_match = (incoming.price >= price_level);
-        else price_match = (incoming.price <= price_level);
-        if (!price_match) break;
-        auto& queue = it->second;
-        while (!queue.empty() && incoming.quantity > 0) {
-            Order& top = queue.front();
-            int trade_qty = std::min(incoming.quantity, top.quantity);
-            std::cout << "Matched Order " << incoming.order_id
-                      << " with Order " << top.order_id
-                      << " at Price " << price_level
-                      << " for Quantity " << trade_qty << std::endl;
-            incoming.quantity -= trade_qty;
-            top.quantity -= trade_qty;
-            if (top.quantity == 0) {
-                queue.pop();
-            }
-            if (incoming.quantity == 0) {
-                incoming.status = OrderStatus::FILLED;
-            } else {
-                incoming.status = OrderStatus::PARTIALLY_FILLED;
-            }
-            // Write match info to CSV
-            auto end = std::chrono::high_resolution_clock::now();
-            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-            latency_log << incoming.order_id << "," << top.order_id << "," << price_level << "," << trade_qty << "," << ns << "\n";
-        }
-        if (queue.empty()) {
-            it = (*opposite_book).erase(it);
-        } else {
-            ++it;
-        }
-    }
-    if (incoming.quantity > 0 && incoming.type == OrderType::LIMIT) {
-        book.add_order(incoming);
+    auto prev = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        match_unlocked(batch[i], book);
+        auto now = std::chrono::high_resolution_clock::now();
+        if (i < latency_ns.size()) latency_ns[i] = std::chrono::duration<double, std::nano>(now - prev).count();
+        prev = now;
     }
 }
+
+template void Matcher::match_order(Order&, BasicOrderBook<NullLock>&);
+template void Matcher::match_order(Order&, BasicOrderBook<SpinLock>&);
+template void Matcher::match_order(Order&, BasicOrderBook<std::mutex>&);
+template void Matcher::match_batch(std::span<Order>, BasicOrderBook<NullLock>&, std::span<double>);
+template void Matcher::match_batch(std::span<Order>, BasicOrderBook<SpinLock>&, std::span<double>);
+template void Matcher::match_batch(std::span<Order>, BasicOrderBook<std::mutex>&, std::span<double>);
@@ -1,231 +1,427 @@
 #include "order_book.hpp"
-#include <iostream>
-#include <map>
-#include <queue>
-#include <algorithm> // For std::remove_if
+#include "utils/logger.hpp"
+#include <algorithm>
 using namespace std;
 
+// Unlink an order from its level at `price` in `ladder`, erasing the level if it becomes empty.
+template <typename Ladder>
+static void unlink_from(Ladder& ladder, OrderStore& orders, OrderHandle h, Price price) {
+    OrderList* level = ladder.find(price);
+    level->erase(orders, h);
+    if (level->empty()) ladder.erase(price);
+}
+
+// Copy up to `n` levels of `ladder` into `out`, best first.
+template <typename Ladder>
+static size_t collect_depth(const Ladder& ladder, DepthLevel* out, size_t n) {
+    size_t count = 0;
+    if (n == 0) return 0;
+    ladder.for_each_level([&](Price price, const OrderList& level) {
+        out[count++] = DepthLevel{price, level.quantity(), (int)level.size()};
+        return count < n;
+    });
+    return count;
+}
+
+template <typename L>
+BasicOrderBook<L>::BasicOrderBook(const BookConfig& config)
+    : orders(config.max_orders),
+      buy_book(config.max_levels, config.max_ladder_ticks),
+      sell_book(config.max_levels, config.max_ladder_ticks),
+      order_index(config.index_mode, config.max_orders),
+      tick_size(config.tick_size),
+      buy_stops(config.max_levels, config.max_ladder_ticks),
+      sell_stops(config.max_levels, config.max_ladder_ticks),
+      stop_policy(config.stop_policy) {
+    fired.reserve(64);
+    activated.reserve(64);
+}
+
+template <typename L>
+BasicOrderBook<L>::~BasicOrderBook() = default;
+
+template <typename L>
+void BasicOrderBook<L>::unlink_order(OrderHandle h) {
+    if (orders[h].side == Side::BUY) {
+        unlink_from(buy_book, orders, h, orders[h].price);
+    } else {
+        unlink_from(sell_book, orders, h, orders[h].price);
+    }
+}
+
+template <typename L>
+void BasicOrderBook<L>::unlink_stop(OrderHandle h) {
+    if (orders[h].side == Side::BUY) {
+        unlink_from(buy_stops, orders, h, orders.cold(h).stop_price);
+    } else {
+        unlink_from(sell_stops, orders, h, orders.cold(h).stop_price);
+    }
+}
+
+template <typename L>
+bool BasicOrderBook<L>::is_pending_stop(OrderHandle h) const {
+    const OrderCold& c = orders.cold(h);
+    return (c.type == OrderType::STOP || c.type == OrderType::STOP_LIMIT) && !c.triggered;
+}
+
+template <typename L>
+void BasicOrderBook<L>::release_order(OrderHandle h) {
+    order_index.erase(orders[h].order_id);
+    orders.release(h);
+}
+
 // Add an order to the book. Handles LIMIT, MARKET, STOP, and STOP_LIMIT orders.
 // MARKET orders match immediately with the best available price on the opposite side.
 // STOP and STOP_LIMIT orders are stored until triggered by price movement.
-void OrderBook::add_order(const Order& order) {
-    lock_guard<recursive_mutex> lock(book_mutex);
+template <typename L>
+void BasicOrderBook<L>::add_order(const Order& order) {
+    lock_guard<L> lock(book_mutex);
+    add_unlocked(order);
+}
+
+template <typename L>
+void BasicOrderBook<L>::add_unlocked(const Order& order) {
+    enter(order);
+    run_stops();
+}
 
+template <typename L>
+void BasicOrderBook<L>::enter(const Order& order) {
     // Handle STOP and STOP_LIMIT orders: store until triggered
     if (order.type == OrderType::STOP || order.type == OrderType::STOP_LIMIT) {
         // For beginners: stop orders are not active until the market price crosses the stop price.
-        stop_orders.push_back(order);
-        std::cout << "Stop order stored (OrderID: " << order.order_id << ", Stop Price: " << order.stop_price << ")\n";
+        OrderHandle h = orders.acquire(order);
+        if (order.side == Side::BUY) {
+            buy_stops[order.stop_price].push_back(orders, h);
+        } else {
+            sell_stops[order.stop_price].push_back(orders, h);
+        }
+        order_index.insert(order.order_id, h);
+        LOG_INFO("Stop order stored (OrderID: {}, Stop Price: {})", order.order_id, order.stop_price.to_double(tick_size));
+        // The new stop may already be crossed
+        collect_stops();
         return;
     }
 
     if (order.type == OrderType::MARKET) {
-        // MARKET ORDER LOGIC
-        int remaining = order.quantity;
+        // MARKET ORDER LOGIC: take liquidity from the opposite side until filled or the book is empty
+        Order taker = order;
         if (order.side == Side::BUY) {
-            // Buy market order: match with lowest sell prices
-            while (remaining > 0 && !sell_book.empty()) {
-                auto it = sell_book.begin(); // lowest price
-                std::queue<Order>& queue = it->second;
-                while (remaining > 0 && !queue.empty()) {
-                    Order top = queue.front(); queue.pop();
-                    int fill_qty = std::min(remaining, top.quantity - top.filled);
-                    // Fill the order
-                    remaining -= fill_qty;
-                    top.filled += fill_qty;
-                    // Print fill info (for demo)
-                    std::cout << "Market BUY filled " << fill_qty << " @ " << it->first << " (OrderID: " << top.order_id << ")\n";
-                    if (top.filled < top.quantity) {
-                        queue.push(top); // Put back partially filled order
-                    } else {
-                        // Fully filled, remove from index
-                        order_index.erase(top.order_id);
-                    }
-                }
-                if (queue.empty()) sell_book.erase(it);
-            }
+            match_unlocked<Side::BUY>(taker, [&](int maker_id, Price price, int qty) {
+                LOG_INFO("Market BUY filled {} @ {} (OrderID: {})", qty, price.to_double(tick_size), maker_id);
+            });
         } else {
-            // Sell market order: match with highest buy prices
-            while (remaining > 0 && !buy_book.empty()) {
-                auto it = buy_book.begin(); // highest price (map is greater<>)
-                std::queue<Order>& queue = it->second;
-                while (remaining > 0 && !queue.empty()) {
-                    Order top = queue.front(); queue.pop();
-                    int fill_qty = std::min(remaining, top.quantity - top.filled);
-                    remaining -= fill_qty;
-                    top.filled += fill_qty;
-                    std::cout << "Market SELL filled " << fill_qty << " @ " << it->first << " (OrderID: " << top.order_id << ")\n";
-                    if (top.filled < top.quantity) {
-                        queue.push(top);
-                    } else {
-                        order_index.erase(top.order_id);
-                    }
-                }
-                if (queue.empty()) buy_book.erase(it);
-            }
+            match_unlocked<Side::SELL>(taker, [&](int maker_id, Price price, int qty) {
+                LOG_INFO("Market SELL filled {} @ {} (OrderID: {})", qty, price.to_double(tick_size), maker_id);
+            });
         }
-        // Note: If remaining > 0, the market order was not fully filled (book empty)
+        // Note: If the taker is not fully filled, the rest is dropped (book empty)
+        check_stops();
         return;
     }
 
     // LIMIT ORDER LOGIC (default)
+    OrderHandle h = orders.acquire(order);
     if (order.side == Side::BUY) {
-        buy_book[order.price].push(order);
+        buy_book[order.price].push_back(orders, h);
     } else {
-        sell_book[order.price].push(order);
+        sell_book[order.price].push_back(orders, h);
     }
-    order_index[order.order_id] = {order.price, order.side};
+    order_index.insert(order.order_id, h);
 
     // After every new order, check if any stop/stop-limit orders should be triggered
     // For beginners: If the market price crosses a stop order's price, it becomes active
-    std::vector<Order> still_pending;
-    for (auto& stop_order : stop_orders) {
-        bool trigger = false;
-        if (!stop_order.triggered) {
-            if (stop_order.side == Side::BUY) {
-                // Buy stop triggers if best ask >= stop_price
-                if (!sell_book.empty() && sell_book.begin()->first >= stop_order.stop_price) trigger = true;
-            } else {
-                // Sell stop triggers if best bid <= stop_price
-                if (!buy_book.empty() && buy_book.begin()->first <= stop_order.stop_price) trigger = true;
-            }
-        }
-        if (trigger) {
-            std::cout << "Stop order triggered (OrderID: " << stop_order.order_id << ")\n";
-            Order active = stop_order;
-            active.triggered = true;
-            // STOP becomes MARKET, STOP_LIMIT becomes LIMIT
-            if (active.type == OrderType::STOP) {
-                active.type = OrderType::MARKET;
-            } else if (active.type == OrderType::STOP_LIMIT) {
-                active.type = OrderType::LIMIT;
-            }
-            add_order(active); // Recursively add as active order
-        } else {
-            still_pending.push_back(stop_order);
-        }
+    check_stops();
+}
+
+template <typename L>
+void BasicOrderBook<L>::restore_order(const Order& order) {
+    lock_guard<L> lock(book_mutex);
+    OrderHandle h = orders.acquire(order);
+    bool pending_stop = (order.type == OrderType::STOP || order.type == OrderType::STOP_LIMIT) && !order.triggered;
+    if (pending_stop) {
+        if (order.side == Side::BUY) buy_stops[order.stop_price].push_back(orders, h);
+        else sell_stops[order.stop_price].push_back(orders, h);
+    } else {
+        if (order.side == Side::BUY) buy_book[order.price].push_back(orders, h);
+        else sell_book[order.price].push_back(orders, h);
     }
-    stop_orders = std::move(still_pending);
+    order_index.insert(order.order_id, h);
 }
 
-// Cancel an order by ID. Handles both active and pending stop/stop-limit orders.
-void OrderBook::cancel_order(int order_id) {
-    lock_guard<recursive_mutex> lock(book_mutex);
-
-    // First, try to remove from active order books
-    if (order_index.find(order_id) != order_index.end()) {
-        auto [price, side] = order_index[order_id];
-        std::map<double, std::queue<Order>>* book;
-        if (side == Side::BUY) {
-            book = reinterpret_cast<std::map<double, std::queue<Order>>*>(&buy_book);
-        } else {
-            book = &sell_book;
+template <typename L>
+void BasicOrderBook<L>::restore_last_trade(Price price) {
+    lock_guard<L> lock(book_mutex);
+    last_trade = price;
+    checked_bid = buy_book.empty() ? NO_PRICE : buy_book.best_price();
+    checked_ask = sell_book.empty() ? NO_PRICE : sell_book.best_price();
+    checked_trade = last_trade;
+}
+
+template <typename L>
+void BasicOrderBook<L>::trigger_stops() {
+    lock_guard<L> lock(book_mutex);
+    trigger_stops_unlocked();
+}
+
+template <typename L>
+void BasicOrderBook<L>::trigger_stops_unlocked() {
+    check_stops();
+    run_stops();
+}
+
+template <typename L>
+void BasicOrderBook<L>::check_stops() {
+    Price bid = buy_book.empty() ? NO_PRICE : buy_book.best_price();
+    Price ask = sell_book.empty() ? NO_PRICE : sell_book.best_price();
+    if (bid == checked_bid && ask == checked_ask && last_trade == checked_trade) return;
+    checked_bid = bid;
+    checked_ask = ask;
+    checked_trade = last_trade;
+    collect_stops();
+}
+
+template <typename L>
+void BasicOrderBook<L>::collect_stops() {
+    bool use_quotes = stop_policy != StopTriggerPolicy::TRADES;
+    bool use_trades = stop_policy != StopTriggerPolicy::QUOTES && last_trade != NO_PRICE;
+    Price bid = buy_book.empty() ? NO_PRICE : buy_book.best_price();
+    Price ask = sell_book.empty() ? NO_PRICE : sell_book.best_price();
+
+    // Only the front of each stop ladder needs checking: buy stops trigger once the
+    // reference price rises to the stop price, sell stops once it falls to it.
+    fired.clear();
+    while (!buy_stops.empty()) {
+        Price stop = buy_stops.best_price();
+        bool hit = (use_quotes && ask != NO_PRICE && ask >= stop) || (use_trades && last_trade >= stop);
+        if (!hit) break;
+        for (OrderHandle h = buy_stops.best().front(); h != NULL_HANDLE; h = orders[h].next) fired.push_back(h);
+        buy_stops.erase(stop);
+    }
+    while (!sell_stops.empty()) {
+        Price stop = sell_stops.best_price();
+        bool hit = (use_quotes && bid != NO_PRICE && bid <= stop) || (use_trades && last_trade <= stop);
+        if (!hit) break;
+        for (OrderHandle h = sell_stops.best().front(); h != NULL_HANDLE; h = orders[h].next) fired.push_back(h);
+        sell_stops.erase(stop);
+    }
+    if (fired.empty()) return;
+
+    // Activate in time priority across all crossed stop levels
+    std::sort(fired.begin(), fired.end(), [this](OrderHandle a, OrderHandle b) {
+        return orders.cold(a).sequence < orders.cold(b).sequence;
+    });
+    for (OrderHandle h : fired) {
+        activated.push_back(orders.to_order(h));
+        release_order(h);
+    }
+}
+
+template <typename L>
+void BasicOrderBook<L>::run_stops() {
+    // Stops fired while running earlier ones are appended and run after them
+    while (next_activated < activated.size()) {
+        Order active = activated[next_activated++];
+        LOG_INFO("Stop order triggered (OrderID: {})", active.order_id);
+        active.triggered = true;
+        // STOP becomes MARKET, STOP_LIMIT becomes LIMIT
+        if (active.type == OrderType::STOP) {
+            active.type = OrderType::MARKET;
+            enter(active);
+            continue;
         }
-        // Work on a copy, then assign back
-        std::queue<Order> new_queue;
-        {
-            std::queue<Order>& orig_queue = (*book)[price];
-            while (!orig_queue.empty()) {
-                Order ord = orig_queue.front(); orig_queue.pop();
-                if (ord.order_id != order_id) {
-                    new_queue.push(ord);
-                }
-            }
+        active.type = OrderType::LIMIT;
+        // A triggered stop-limit takes liquidity up to its limit before resting
+        auto print_fill = [&](int maker_id, Price price, int qty) {
+            LOG_INFO("Stop-limit {} filled {} @ {} (OrderID: {})", active.order_id, qty, price.to_double(tick_size), maker_id);
+        };
+        if (active.side == Side::BUY) {
+            match_unlocked<Side::BUY>(active, print_fill);
+        } else {
+            match_unlocked<Side::SELL>(active, print_fill);
         }
-        if (new_queue.empty()) {
-            book->erase(price);
+        if (active.filled < active.quantity) {
+            enter(active);
         } else {
-            (*book)[price] = std::move(new_queue);
+            check_stops();
         }
-        order_index.erase(order_id);
-        std::cout << "Order " << order_id << " canceled from active book.\n";
-        return;
     }
+    activated.clear();
+    next_activated = 0;
+}
 
-    // Next, try to remove from pending stop/stop-limit orders
-    auto it = std::remove_if(stop_orders.begin(), stop_orders.end(), [order_id](const Order& o) {
-        return o.order_id == order_id;
-    });
-    if (it != stop_orders.end()) {
-        stop_orders.erase(it, stop_orders.end());
-        std::cout << "Order " << order_id << " canceled from pending stop orders.\n";
+// Cancel an order by ID. Handles both active and pending stop/stop-limit orders.
+template <typename L>
+void BasicOrderBook<L>::cancel_order(int order_id) {
+    lock_guard<L> lock(book_mutex);
+
+    OrderHandle h = order_index.find(order_id);
+    if (h == NULL_HANDLE) return;
+    cancel_unlocked(h, order_id);
+}
+
+template <typename L>
+void BasicOrderBook<L>::cancel_unlocked(OrderHandle h, int order_id) {
+    // Pending stop/stop-limit orders live in the stop ladders
+    if (is_pending_stop(h)) {
+        unlink_stop(h);
+        release_order(h);
+        LOG_INFO("Order {} canceled from pending stop orders.", order_id);
+        return;
     }
+
+    unlink_order(h);
+    release_order(h);
+    LOG_INFO("Order {} canceled from active book.", order_id);
+    trigger_stops_unlocked();
 }
 
 // Modify an order by ID. Handles both active and pending stop/stop-limit orders.
-void OrderBook::modify_order(int order_id, double new_price, int new_qty) {
-    lock_guard<recursive_mutex> lock(book_mutex);
-
-    // First, try to modify in active order books
-    if (order_index.find(order_id) != order_index.end()) {
-        auto [old_price, side] = order_index[order_id];
-        std::map<double, std::queue<Order>>* book;
-        if (side == Side::BUY) {
-            book = reinterpret_cast<std::map<double, std::queue<Order>>*>(&buy_book);
-        } else {
-            book = &sell_book;
-        }
+template <typename L>
+void BasicOrderBook<L>::modify_order(int order_id, Price new_price, int new_qty) {
+    lock_guard<L> lock(book_mutex);
 
-        std::queue<Order> new_queue;
-        Order modified_order(0, 0, side, OrderType::LIMIT, 0.0, 0);
-        bool found = false;
-        {
-            std::queue<Order>& orig_queue = (*book)[old_price];
-            while (!orig_queue.empty()) {
-                Order ord = orig_queue.front(); orig_queue.pop();
-                if (ord.order_id == order_id) {
-                    ord.price = new_price;
-                    ord.quantity = new_qty;
-                    modified_order = ord;
-                    found = true;
-                } else {
-                    new_queue.push(ord);
-                }
-            }
-        }
-        if (new_queue.empty()) {
-            book->erase(old_price);
+    OrderHandle h = order_index.find(order_id);
+    if (h == NULL_HANDLE) return;
+    OrderNode& resting = orders[h];
+    int filled = orders.cold(h).filled;
+
+    // A size at or below what has already filled leaves nothing to rest
+    if (new_qty <= filled) {
+        cancel_unlocked(h, order_id);
+        return;
+    }
+
+    // Pending stop/stop-limit orders are updated where they wait; a larger size goes to
+    // the back of the stop level, as for resting orders
+    if (is_pending_stop(h)) {
+        Price stop = orders.cold(h).stop_price;
+        OrderList* level = (resting.side == Side::BUY) ? buy_stops.find(stop) : sell_stops.find(stop);
+        int remaining = new_qty - filled;
+        if (remaining <= resting.quantity) {
+            level->reduce(orders, h, resting.quantity - remaining);
         } else {
-            (*book)[old_price] = std::move(new_queue);
-        }
-        order_index.erase(order_id);
-        if (found) {
-            add_order(modified_order);
-            std::cout << "Order " << order_id << " modified in active book.\n";
+            level->erase(orders, h);
+            resting.quantity = remaining;
+            orders.requeue(h);
+            level->push_back(orders, h);
         }
+        resting.price = new_price; // For stop-limit, this is the new limit price
+        LOG_INFO("Order {} modified in pending stop orders.", order_id);
         return;
     }
 
-    // Next, try to modify in pending stop/stop-limit orders
-    for (auto& o : stop_orders) {
-        if (o.order_id == order_id) {
-            o.price = new_price; // For stop-limit, this is the new limit price
-            o.quantity = new_qty;
-            std::cout << "Order " << order_id << " modified in pending stop orders.\n";
-            break;
-        }
+    if (new_price == resting.price && new_qty <= resting.quantity + filled) {
+        // Reducing size at the same price keeps the order's place in the queue
+        OrderList* level = (resting.side == Side::BUY) ? buy_book.find(resting.price) : sell_book.find(resting.price);
+        level->reduce(orders, h, resting.quantity - (new_qty - filled));
+        LOG_INFO("Order {} modified in place.", order_id);
+        return;
     }
+    // Any other change loses time priority: remove and re-add
+    Order modified_order = orders.to_order(h);
+    unlink_order(h);
+    release_order(h);
+    modified_order.price = new_price;
+    modified_order.quantity = new_qty;
+    add_unlocked(modified_order);
+    LOG_INFO("Order {} modified in active book.", order_id);
 }
 
+template <typename L>
+void BasicOrderBook<L>::print_top_levels(int depth) {
+    lock_guard<L> lock(book_mutex);
 
-void OrderBook::print_top_levels(int depth) {
-    lock_guard<recursive_mutex> lock(book_mutex);
-
-    cout << "=== ORDER BOOK ===" << endl;
-    cout << "SELL SIDE:" << endl;
+    LOG_INFO("=== ORDER BOOK ===");
+    LOG_INFO("SELL SIDE:");
 
     int count = 0;
-    for (const auto& [price, queue] : sell_book) {
-        cout << "Price: " << price << " | Orders: " << queue.size() << endl;
-        if (++count >= depth) break;
-    }
+    auto print_level = [&](Price price, const OrderList& level) {
+        LOG_INFO("Price: {} | Qty: {} | Orders: {}", price.to_double(tick_size), level.quantity(), level.size());
+        return ++count < depth;
+    };
+    sell_book.for_each_level(print_level);
 
-    cout << "BUY SIDE:" << endl;
+    LOG_INFO("BUY SIDE:");
     count = 0;
-    for (const auto& [price, queue] : buy_book) {
-        cout << "Price: " << price << " | Orders: " << queue.size() << endl;
-        if (++count >= depth) break;
+    buy_book.for_each_level(print_level);
+
+    LOG_INFO("==================");
+}
+
+template <typename L>
+size_t BasicOrderBook<L>::depth_unlocked(Side side, DepthLevel* out, size_t n) {
+    return side == Side::BUY ? collect_depth(buy_book, out, n) : collect_depth(sell_book, out, n);
+}
+
+template <typename L>
+size_t BasicOrderBook<L>::depth(Side side, DepthLevel* out, size_t n) {
+    lock_guard<L> lock(book_mutex);
+    return depth_unlocked(side, out, n);
+}
+
+template <typename L>
+std::vector<DepthLevel> BasicOrderBook<L>::depth(Side side, size_t n) {
+    lock_guard<L> lock(book_mutex);
+    std::vector<DepthLevel> levels(std::min(n, side == Side::BUY ? buy_book.size() : sell_book.size()));
+    levels.resize(depth_unlocked(side, levels.data(), levels.size()));
+    return levels;
+}
+
+template <typename L>
+int64_t BasicOrderBook<L>::available_liquidity(Side taker_side, Price limit) {
+    lock_guard<L> lock(book_mutex);
+    int64_t total = 0;
+    auto add_level = [&](Price price, const OrderList& level) {
+        bool crosses = (taker_side == Side::BUY) ? price <= limit : price >= limit;
+        if (crosses) total += level.quantity();
+        return crosses;
+    };
+    if (taker_side == Side::BUY) {
+        sell_book.for_each_level(add_level);
+    } else {
+        buy_book.for_each_level(add_level);
     }
+    return total;
+}
 
-    cout << "==================" << endl;
+template <typename L>
+std::vector<Order> BasicOrderBook<L>::pending_stops(size_t max_orders) {
+    lock_guard<L> lock(book_mutex);
+    std::vector<Order> stops;
+    auto collect = [&](Price, const OrderList& level) {
+        for (OrderHandle h = level.front(); h != NULL_HANDLE && stops.size() < max_orders; h = orders[h].next) {
+            stops.push_back(orders.to_order(h));
+        }
+        return stops.size() < max_orders;
+    };
+    buy_stops.for_each_level(collect);
+    sell_stops.for_each_level(collect);
+    return stops;
 }
+
+template <typename L>
+void BasicOrderBook<L>::snapshot(BookSnapshot& out) {
+    lock_guard<L> lock(book_mutex);
+    out.tick_size = tick_size;
+    out.best_bid = buy_book.empty() ? NO_PRICE : buy_book.best_price();
+    out.best_ask = sell_book.empty() ? NO_PRICE : sell_book.best_price();
+    out.last_trade = last_trade;
+    out.bid_levels = collect_depth(buy_book, out.bids, BookSnapshot::LEVELS);
+    out.ask_levels = collect_depth(sell_book, out.asks, BookSnapshot::LEVELS);
+    out.stop_count = 0;
+    auto collect = [&](Price, const OrderList& level) {
+        for (OrderHandle h = level.front(); h != NULL_HANDLE && out.stop_count < BookSnapshot::STOPS; h = orders[h].next) {
+            const OrderNode& n = orders[h];
+            const OrderCold& c = orders.cold(h);
+            out.stops[out.stop_count++] = PendingStop{n.order_id, n.side, c.type, n.quantity, c.stop_price, n.price};
+        }
+        return out.stop_count < BookSnapshot::STOPS;
+    };
+    buy_stops.for_each_level(collect);
+    sell_stops.for_each_level(collect);
+}
+
+template class BasicOrderBook<NullLock>;
+template class BasicOrderBook<SpinLock>;
+template class BasicOrderBook<std::mutex>;
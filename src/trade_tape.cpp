@@ -0,0 +1,157 @@
+#include "trade_tape.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+[[noreturn]] static void fatal(const char* what) {
+    fprintf(stderr, "trade tape: %s failed: %s\n", what, strerror(errno));
+    abort();
+}
+
+static string tape_path(const string& dir, size_t shard, uint64_t first_trade) {
+    char name[64];
+    snprintf(name, sizeof(name), "shard%zu-%020" PRIu64 ".tape", shard, first_trade);
+    return dir + "/" + name;
+}
+
+void TradeTapeConfig::validate() const {
+    if (segment_bytes < sizeof(TradeTapeHeader) + sizeof(TradeRecord)) throw invalid_argument("trade tape segment too small");
+}
+
+TradeTapeConfig TradeTapeConfig::from_env() {
+    TradeTapeConfig config;
+    if (const char* v = getenv("LOB_TAPE_DIR")) config.dir = v;
+    if (const char* v = getenv("LOB_TAPE_SEGMENT_MB")) {
+        size_t used = 0;
+        unsigned long mb = 0;
+        try { mb = stoul(v, &used); } catch (const exception&) {}
+        if (used == 0 || v[used] != '\0' || mb == 0) throw invalid_argument(string("bad LOB_TAPE_SEGMENT_MB: ") + v);
+        config.segment_bytes = size_t(mb) << 20;
+    }
+    config.validate();
+    return config;
+}
+
+vector<pair<uint64_t, string>> TradeTape::files(const string& dir, size_t shard) {
+    vector<pair<uint64_t, string>> found;
+    string prefix = "shard" + to_string(shard) + "-";
+    error_code ec;
+    for (const auto& entry : filesystem::directory_iterator(dir, ec)) {
+        string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) != 0 || entry.path().extension() != ".tape") continue;
+        found.emplace_back(stoull(name.substr(prefix.size())), entry.path().string());
+    }
+    sort(found.begin(), found.end());
+    return found;
+}
+
+TradeTape::TradeTape(const TradeTapeConfig& config_, size_t shard_, double tick_size_)
+    : config(config_), shard(shard_), tick_size(tick_size_), buffer(WRITE_RECORDS) {
+    config.validate();
+    error_code ec;
+    filesystem::create_directories(config.dir, ec);
+    if (ec) throw runtime_error("cannot create trade tape directory " + config.dir + ": " + ec.message());
+    // Number on from the last whole record of the newest file
+    auto existing = files(config.dir, shard);
+    if (!existing.empty()) {
+        uint64_t size = filesystem::file_size(existing.back().second, ec);
+        uint64_t whole = !ec && size > sizeof(TradeTapeHeader) ? (size - sizeof(TradeTapeHeader)) / sizeof(TradeRecord) : 0;
+        next_trade = existing.back().first + whole;
+    }
+    written_trades = next_trade;
+    writer = thread([this] { run(); });
+}
+
+void TradeTape::close() {
+    if (!writer.joinable()) return;
+    stopping.store(true, memory_order_release);
+    writer.join();
+    close_file();
+}
+
+TradeTapeStats TradeTape::stats() const {
+    return {records.load(memory_order_relaxed), writes.load(memory_order_relaxed), bytes.load(memory_order_relaxed),
+            files_opened.load(memory_order_relaxed), full.load(memory_order_relaxed)};
+}
+
+void TradeTape::run() {
+    size_t n = 0;
+    auto last_write = chrono::steady_clock::now();
+    while (true) {
+        while (n < WRITE_RECORDS) {
+            TradeRecord* r = ring.front();
+            if (!r) break;
+            buffer[n++] = *r;
+            ring.pop();
+        }
+        // Appends before the stop request are in the ring by now
+        bool stop = stopping.load(memory_order_acquire) && ring.empty();
+        auto now = chrono::steady_clock::now();
+        if (n == WRITE_RECORDS || (n > 0 && (stop || now - last_write >= FLUSH_INTERVAL))) {
+            write_buffer(n);
+            n = 0;
+            last_write = now;
+            continue;
+        }
+        if (stop) break;
+        if (n == 0) last_write = now;   // The interval runs from the first buffered trade
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+void TradeTape::write_buffer(size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        if (fd < 0 || offset + sizeof(TradeRecord) > config.segment_bytes) {
+            close_file();
+            open_file(written_trades);
+        }
+        size_t count = min((config.segment_bytes - offset) / sizeof(TradeRecord), n - done);
+        const char* p = reinterpret_cast<const char*>(&buffer[done]);
+        size_t left = count * sizeof(TradeRecord);
+        while (left > 0) {
+            ssize_t w = ::write(fd, p, left);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                fatal("write");
+            }
+            p += w;
+            left -= w;
+            offset += w;
+        }
+        writes.fetch_add(1, memory_order_relaxed);
+        done += count;
+        written_trades += count;
+    }
+    records.fetch_add(n, memory_order_relaxed);
+    bytes.fetch_add(n * sizeof(TradeRecord), memory_order_relaxed);
+}
+
+// Called on the tape thread; a file that cannot be created is fatal, as for the journal
+void TradeTape::open_file(uint64_t first_trade) {
+    string path = tape_path(config.dir, shard, first_trade);
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) fatal("open");
+    TradeTapeHeader header{};
+    memcpy(header.magic, TRADE_TAPE_MAGIC, sizeof(header.magic));
+    header.version = TRADE_TAPE_VERSION;
+    header.record_size = sizeof(TradeRecord);
+    header.shard = shard;
+    header.first_trade = first_trade;
+    header.tick_size = tick_size;
+    if (::write(fd, &header, sizeof(header)) != ssize_t(sizeof(header))) fatal("write");
+    offset = sizeof(header);
+    files_opened.fetch_add(1, memory_order_relaxed);
+}
+
+void TradeTape::close_file() {
+    if (fd < 0) return;
+    ::close(fd);
+    fd = -1;
+}
@@ -1,38 +1,709 @@
 #include "order_book.hpp"
+#include "engine.hpp"
+#include "order_ingress.hpp"
+#include "latency_metrics.hpp"
+#include "seqlock.hpp"
+#include "csv_replay.hpp"
+#include "mapped_file.hpp"
+#include "event_file.hpp"
+#include "trade_tape.hpp"
+#include "utils/logger.hpp"
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <chrono>
+#include <thread>
 #include <iostream>
 
+// Convert a decimal test price to ticks at the default tick size
+static Price px(double p) { return Price::from_double(p); }
+
 // Simple test for market, stop, and stop-limit orders
 int main() {
     OrderBook ob;
     long long ts = 1;
 
     // Add some limit orders to create a book
-    ob.add_order(Order(1, ts++, Side::SELL, OrderType::LIMIT, 100.0, 10)); // Sell 10 @ 100
-    ob.add_order(Order(2, ts++, Side::SELL, OrderType::LIMIT, 101.0, 10)); // Sell 10 @ 101
-    ob.add_order(Order(3, ts++, Side::BUY, OrderType::LIMIT, 99.0, 10));   // Buy 10 @ 99
-    ob.add_order(Order(4, ts++, Side::BUY, OrderType::LIMIT, 98.0, 10));   // Buy 10 @ 98
+    ob.add_order(Order(1, ts++, Side::SELL, OrderType::LIMIT, px(100.0), 10)); // Sell 10 @ 100
+    ob.add_order(Order(2, ts++, Side::SELL, OrderType::LIMIT, px(101.0), 10)); // Sell 10 @ 101
+    ob.add_order(Order(3, ts++, Side::BUY, OrderType::LIMIT, px(99.0), 10));   // Buy 10 @ 99
+    ob.add_order(Order(4, ts++, Side::BUY, OrderType::LIMIT, px(98.0), 10));   // Buy 10 @ 98
 
     // Test market buy (should fill at 100)
-    ob.add_order(Order(10, ts++, Side::BUY, OrderType::MARKET, 0.0, 5));
+    ob.add_order(Order(10, ts++, Side::BUY, OrderType::MARKET, Price(), 5));
     // Test market sell (should fill at 99)
-    ob.add_order(Order(11, ts++, Side::SELL, OrderType::MARKET, 0.0, 5));
+    ob.add_order(Order(11, ts++, Side::SELL, OrderType::MARKET, Price(), 5));
 
     // Test stop buy (should trigger when best ask >= 102)
-    ob.add_order(Order(20, ts++, Side::BUY, OrderType::STOP, 0.0, 5, 102.0));
+    ob.add_order(Order(20, ts++, Side::BUY, OrderType::STOP, Price(), 5, px(102.0)));
     // Add a sell limit at 102 to trigger stop buy
-    ob.add_order(Order(21, ts++, Side::SELL, OrderType::LIMIT, 102.0, 5));
+    ob.add_order(Order(21, ts++, Side::SELL, OrderType::LIMIT, px(102.0), 5));
 
     // Test stop-limit sell (should trigger when best bid <= 97)
-    ob.add_order(Order(30, ts++, Side::SELL, OrderType::STOP_LIMIT, 97.0, 5, 97.0));
+    ob.add_order(Order(30, ts++, Side::SELL, OrderType::STOP_LIMIT, px(97.0), 5, px(97.0)));
     // Add a buy limit at 97 to trigger stop-limit sell
-    ob.add_order(Order(31, ts++, Side::BUY, OrderType::LIMIT, 97.0, 5));
+    ob.add_order(Order(31, ts++, Side::BUY, OrderType::LIMIT, px(97.0), 5));
 
     // Test cancel and modify for stop order
-    ob.add_order(Order(40, ts++, Side::BUY, OrderType::STOP, 0.0, 5, 105.0));
+    ob.add_order(Order(40, ts++, Side::BUY, OrderType::STOP, Price(), 5, px(105.0)));
     ob.cancel_order(40); // Should remove from stop_orders
-    ob.add_order(Order(41, ts++, Side::SELL, OrderType::STOP_LIMIT, 96.0, 5, 96.0));
-    ob.modify_order(41, 95.0, 10); // Should update price and quantity in stop_orders
+    ob.add_order(Order(41, ts++, Side::SELL, OrderType::STOP_LIMIT, px(96.0), 5, px(96.0)));
+    ob.modify_order(41, px(95.0), 10); // Should update price and quantity in stop_orders
+
+    // Prices that differ only by floating-point noise map to the same tick
+    assert(px(100.1) == px(100.10000001));
+
+    // Orders far outside the initial price window must not disturb the best prices
+    ob.add_order(Order(50, ts++, Side::SELL, OrderType::LIMIT, px(500.0), 1));
+    ob.add_order(Order(51, ts++, Side::BUY, OrderType::LIMIT, px(1.0), 1));
+    assert(ob.sell_book.best_price() == px(100.0));
+    assert(ob.buy_book.best_price() == px(99.0));
+    ob.cancel_order(50);
+    ob.cancel_order(51);
+    assert(ob.sell_book.size() == 3);
+
+    // An outlier price does not blow up the array ladder's window: levels past the cap go
+    // to its overflow map, keep their place in price order, and rejoin the window when it moves
+    {
+        ArrayLadder<Side::SELL, OrderList> ladder(64, 1024);
+        ladder[Price(10000)];
+        ladder[Price(10010)];
+        ladder[Price(100000000)];
+        ladder[Price(5)];
+        assert(ladder.size() == 4 && ladder.window() <= 1024 && ladder.best_price() == Price(5));
+        std::vector<int64_t> seen;
+        ladder.for_each_level([&](Price p, const OrderList&) { seen.push_back(p.ticks); return true; });
+        assert((seen == std::vector<int64_t>{5, 10000, 10010, 100000000}));
+        ladder.erase(Price(5));
+        assert(ladder.best_price() == Price(10000) && ladder.find(Price(100000000)) != nullptr);
+        ladder.erase(Price(10000));
+        ladder.erase(Price(10010));
+        ladder[Price(99999990)];   // The window moves next to the outlier and takes it back
+        assert(ladder.size() == 2 && ladder.window() <= 1024 && ladder.find(Price(100000000)) != nullptr);
+        ArrayLadder<Side::BUY, OrderList> bids(64, 1024);
+        bids[Price(100)];
+        bids[Price(100000000)];
+        assert(bids.best_price() == Price(100000000) && bids.window() <= 1024);
+
+        OrderBook book;
+        book.add_order(Order(1, 1, Side::SELL, OrderType::LIMIT, px(100.0), 1));
+        book.add_order(Order(2, 2, Side::SELL, OrderType::LIMIT, px(1000000.0), 1));
+        auto asks = book.depth(Side::SELL, 5);
+        assert(asks.size() == 2 && asks[0].price == px(100.0) && asks[1].price == px(1000000.0));
+        book.add_order(Order(3, 3, Side::BUY, OrderType::MARKET, Price(), 2));
+        assert(book.sell_book.empty());
+    }
+
+    // Modifying size down at the same price keeps queue priority; increasing it does not
+    ob.add_order(Order(60, ts++, Side::SELL, OrderType::LIMIT, px(101.0), 5));
+    ob.modify_order(2, px(101.0), 4);
+    assert(ob.orders[ob.sell_book.find(px(101.0))->front()].order_id == 2);
+    ob.modify_order(2, px(101.0), 20);
+    assert(ob.orders[ob.sell_book.find(px(101.0))->front()].order_id == 60);
+    ob.cancel_order(60);
+    assert(ob.sell_book.find(px(101.0))->size() == 1);
+
+    // Modifying to a size at or below the filled quantity cancels the rest; a pending stop
+    // that grows goes to the back of its stop level
+    {
+        OrderBook book;
+        book.add_order(Order(1, 1, Side::SELL, OrderType::LIMIT, px(100.0), 10));
+        book.add_order(Order(2, 2, Side::BUY, OrderType::MARKET, Price(), 4));
+        book.modify_order(1, px(101.0), 3);
+        assert(book.depth(Side::SELL, 5).empty() && book.order_index.find(1) == NULL_HANDLE);
+        book.add_order(Order(3, 3, Side::BUY, OrderType::STOP, Price(), 2, px(105.0)));
+        book.add_order(Order(4, 4, Side::BUY, OrderType::STOP, Price(), 2, px(105.0)));
+        book.modify_order(3, Price(), 5);
+        book.modify_order(4, Price(), 1);
+        auto stops = book.pending_stops();
+        assert(stops.size() == 2 && stops[0].order_id == 4 && stops[0].quantity == 1);
+        assert(stops[1].order_id == 3 && stops[1].quantity == 5 && book.buy_stops.find(px(105.0))->quantity() == 6);
+        book.modify_order(3, Price(), 0);
+        assert(book.pending_stops().size() == 1 && book.buy_stops.find(px(105.0))->quantity() == 1);
+    }
+
+    // Level aggregates follow fills, cancels and modifies without walking the orders
+    std::vector<DepthLevel> asks = ob.depth(Side::SELL, 2);
+    assert(asks.size() == 2);
+    assert(asks[0].price == px(100.0) && asks[0].quantity == 5 && asks[0].orders == 1);
+    assert(asks[1].price == px(101.0) && asks[1].quantity == 20 && asks[1].orders == 1);
+    assert(ob.available_liquidity(Side::BUY, px(101.0)) == 25);
+    ob.print_top_levels();
+
+    // Published snapshots carry the same top of book as depth(), plus pending stops
+    {
+        BookSnapshot snap, copy;
+        ob.snapshot(snap);
+        assert(snap.best_ask == px(100.0) && snap.best_bid == px(99.0));
+        assert(snap.ask_levels == 3 && snap.asks[1].quantity == 20);
+        assert(snap.stop_count == ob.pending_stops().size());
+        Seqlock<BookSnapshot> published;
+        published.store(snap);
+        published.load(copy);
+        assert(published.version() == 1 && copy.asks[1].quantity == 20);
+    }
+
+    // Crossed stops fire in time priority across stop levels
+    {
+        OrderBook sb;
+        sb.add_order(Order(1, 1, Side::SELL, OrderType::LIMIT, px(100.0), 100));
+        sb.add_order(Order(2, 2, Side::BUY, OrderType::STOP_LIMIT, px(99.0), 1, px(101.0)));
+        sb.add_order(Order(3, 3, Side::BUY, OrderType::STOP_LIMIT, px(99.0), 1, px(100.5)));
+        assert(sb.pending_stops().size() == 2);
+        sb.cancel_order(1);                                                       // ask gone, nothing fires
+        sb.add_order(Order(4, 4, Side::SELL, OrderType::LIMIT, px(102.0), 10));   // ask 102 crosses both
+        assert(sb.pending_stops().empty());
+        assert(sb.orders[sb.buy_book.best().front()].order_id == 2);
+    }
+
+    // With the TRADES policy only trade prints trigger stops
+    {
+        BookConfig config;
+        config.stop_policy = StopTriggerPolicy::TRADES;
+        OrderBook tb(config);
+        tb.add_order(Order(1, 1, Side::SELL, OrderType::LIMIT, px(100.0), 10));
+        tb.add_order(Order(2, 2, Side::BUY, OrderType::STOP, Price(), 1, px(100.0)));
+        tb.add_order(Order(3, 3, Side::SELL, OrderType::LIMIT, px(101.0), 10));  // quote change only
+        assert(tb.pending_stops().size() == 1);
+        tb.add_order(Order(4, 4, Side::BUY, OrderType::MARKET, Price(), 1));      // trade @ 100 fires the stop
+        assert(tb.pending_stops().empty());
+        assert(tb.depth(Side::SELL, 1)[0].quantity == 8);
+    }
+
+    // A triggered stop-limit takes liquidity up to its limit instead of resting crossed
+    {
+        OrderBook lb;
+        lb.add_order(Order(1, 1, Side::SELL, OrderType::LIMIT, px(100.0), 10));
+        lb.add_order(Order(2, 2, Side::BUY, OrderType::STOP_LIMIT, px(101.0), 4, px(100.0)));
+        assert(lb.pending_stops().empty());
+        assert(lb.buy_book.empty());
+        assert(lb.depth(Side::SELL, 1)[0].quantity == 6);
+    }
+
+    // Cascading stops run from a work list, so a non-recursive lock is enough
+    {
+        OrderBook cb;
+        cb.add_order(Order(1, 1, Side::SELL, OrderType::LIMIT, px(100.0), 1));
+        cb.add_order(Order(2, 2, Side::SELL, OrderType::LIMIT, px(101.0), 1));
+        cb.add_order(Order(3, 3, Side::SELL, OrderType::LIMIT, px(102.0), 5));
+        cb.add_order(Order(4, 4, Side::BUY, OrderType::STOP, Price(), 1, px(101.0)));
+        cb.add_order(Order(5, 5, Side::BUY, OrderType::STOP, Price(), 1, px(102.0)));
+        cb.add_order(Order(6, 6, Side::BUY, OrderType::MARKET, Price(), 1));   // ask 101 fires 4, then ask 102 fires 5
+        assert(cb.pending_stops().empty());
+        assert(cb.depth(Side::SELL, 1)[0].quantity == 4);
+    }
+
+    // Engine: each symbol has its own book, matched on the shard that owns it
+    {
+        EngineConfig config;
+        config.symbols = 3;
+        config.shards = 2;
+        config.max_producers = 1;
+        Engine engine(config);
+        engine.start();
+        size_t producer = engine.register_producer();
+        auto on = [](uint32_t symbol, Order o) { o.symbol_id = symbol; return o; };
+        engine.submit(producer, on(0, Order(1, 1, Side::SELL, OrderType::LIMIT, px(100.0), 10)));
+        engine.submit(producer, on(1, Order(2, 2, Side::BUY, OrderType::LIMIT, px(100.0), 4)));   // other book: rests
+        engine.submit(producer, on(2, Order(3, 3, Side::SELL, OrderType::LIMIT, px(50.0), 1)));
+        engine.submit(producer, on(0, Order(4, 4, Side::BUY, OrderType::LIMIT, px(100.0), 3)));   // crosses order 1
+        engine.stop();
+        assert(engine.matched() == 4);
+        assert(engine.shard_of(0) == engine.shard_of(2) && engine.shard_of(0) != engine.shard_of(1));
+        assert(engine.book(0).depth(Side::SELL, 1)[0].quantity == 7);
+        assert(engine.book(0).buy_book.empty());
+        assert(engine.book(1).depth(Side::BUY, 1)[0].quantity == 4);
+        BookSnapshot view;
+        engine.snapshot(2, view);
+        assert(view.ask_levels == 1 && view.best_ask == px(50.0));
+    }
+
+    // A parked (BLOCKING) shard is woken by submit() and by stop()
+    {
+        EngineConfig config;
+        config.wait = WaitStrategy::BLOCKING;
+        Engine engine(config);
+        engine.start();
+        size_t producer = engine.register_producer();
+        for (int i = 0; i < 100; ++i) {
+            engine.submit(producer, Order(i + 1, i, Side::BUY, OrderType::LIMIT, px(99.0), 1));
+            if (i % 10 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));   // let it park
+        }
+        while (engine.matched() < 100) std::this_thread::yield();
+        engine.stop();
+        assert(engine.book(0).depth(Side::BUY, 1)[0].quantity == 100);
+    }
+
+    // Bounded ingress: REJECT refuses new orders at capacity, cancels still have headroom
+    {
+        auto new_order = [](int id) { return OrderMessage::new_order(Order(id, id, Side::BUY, OrderType::LIMIT, px(99.0), 1)); };
+        IngressConfig config;
+        config.capacity = 3;
+        config.cancel_reserve = 1;
+        config.overflow = OverflowPolicy::REJECT;
+        BasicOrderIngress<OrderMessage> ingress(1, config);
+        size_t lane = ingress.register_producer();
+        for (int id = 1; id <= 3; ++id) assert(ingress.push(lane, new_order(id)) == PushResult::ACCEPTED);
+        assert(ingress.push(lane, new_order(4)) == PushResult::REJECTED);
+        assert(ingress.push(lane, OrderMessage::cancel(0, 1)) == PushResult::ACCEPTED);
+        assert(ingress.push(lane, OrderMessage::cancel(0, 2)) == PushResult::REJECTED);
+        IngressStats stats = ingress.stats();
+        assert(stats.depth == 4 && stats.accepted == 4 && stats.rejected == 2 && stats.shed == 0);
+
+        // DROP_OLDEST_NON_CANCEL: the consumer discards the oldest queued new orders, never cancels
+        config.overflow = OverflowPolicy::DROP_OLDEST_NON_CANCEL;
+        BasicOrderIngress<OrderMessage> dropping(1, config);
+        lane = dropping.register_producer();
+        dropping.push(lane, new_order(1));
+        dropping.push(lane, OrderMessage::cancel(0, 7));
+        dropping.push(lane, new_order(2));
+        assert(dropping.push(lane, new_order(3)) == PushResult::ACCEPTED);   // displaces 1
+        assert(dropping.push(lane, new_order(4)) == PushResult::ACCEPTED);   // displaces 2
+        assert(dropping.stats().depth == 3);
+        OrderMessage m = dropping.pop();
+        assert(m.type == MessageType::CANCEL && m.order.order_id == 7);
+        assert(dropping.pop().order.order_id == 3);
+        assert(dropping.pop().order.order_id == 4);
+        assert(dropping.empty());
+        stats = dropping.stats();
+        assert(stats.shed == 2 && stats.rejected == 0 && stats.depth == 0);
+    }
+
+    // Engine applies cancels and modifies from the ingress in order with new orders
+    {
+        Engine engine(EngineConfig{});
+        engine.start();
+        size_t producer = engine.register_producer();
+        engine.submit(producer, Order(1, 1, Side::BUY, OrderType::LIMIT, px(99.0), 5));
+        engine.submit(producer, Order(2, 2, Side::BUY, OrderType::LIMIT, px(98.0), 5));
+        engine.submit(producer, OrderMessage::cancel(0, 1));
+        engine.submit(producer, OrderMessage::modify(0, 2, px(97.0), 3));
+        engine.stop();
+        auto bids = engine.book(0).depth(Side::BUY, 5);
+        assert(bids.size() == 1 && bids[0].price == px(97.0) && bids[0].quantity == 3);
+    }
+
+    // Engine: stops submitted as NEW orders wait on the stop ladders, then fire when the price crosses
+    for (bool pipelined : {false, true}) {
+        EngineConfig config;
+        config.pipelined = pipelined;
+        Engine engine(config);
+        engine.start();
+        size_t producer = engine.register_producer();
+        engine.submit(producer, Order(1, 1, Side::BUY, OrderType::LIMIT, px(99.0), 5));
+        engine.submit(producer, Order(2, 2, Side::BUY, OrderType::LIMIT, px(98.0), 5));
+        engine.submit(producer, Order(3, 3, Side::SELL, OrderType::LIMIT, px(101.0), 5));
+        engine.submit(producer, Order(4, 4, Side::SELL, OrderType::LIMIT, px(102.0), 5));
+        engine.submit(producer, Order(5, 5, Side::BUY, OrderType::STOP, Price(), 2, px(102.0)));
+        engine.submit(producer, Order(6, 6, Side::SELL, OrderType::STOP, Price(), 2, px(98.0)));
+        engine.stop();
+        auto stops = engine.book(0).pending_stops();
+        assert(stops.size() == 2 && stops[0].order_id == 5 && stops[1].order_id == 6);
+        assert(engine.book(0).depth(Side::BUY, 5)[0].quantity == 5 && engine.book(0).depth(Side::SELL, 5)[0].quantity == 5);
+
+        engine.start();
+        engine.submit(producer, Order(7, 7, Side::BUY, OrderType::LIMIT, px(102.0), 6));    // Trades up to 102
+        engine.submit(producer, Order(8, 8, Side::SELL, OrderType::LIMIT, px(98.0), 6));    // Trades down to 98
+        engine.stop();
+        assert(engine.book(0).pending_stops().empty());
+        auto bids = engine.book(0).depth(Side::BUY, 5), asks = engine.book(0).depth(Side::SELL, 5);
+        assert(bids.size() == 1 && bids[0].price == px(98.0) && bids[0].quantity == 2);   // 5 - 1 - 2 (sell stop)
+        assert(asks.size() == 1 && asks[0].price == px(102.0) && asks[0].quantity == 2);  // 5 - 1 - 2 (buy stop)
+    }
+
+    // Pipelined shards give the same books as single-threaded ones; validation rejects bad input
+    for (bool pipelined : {false, true}) {
+        EngineConfig config;
+        config.symbols = 2;
+        config.shards = 2;
+        config.pipelined = pipelined;
+        config.max_order_qty = 100;
+        std::vector<int> seen;
+        config.on_matched = [&](const Order& o) { seen.push_back(o.order_id); };   // shard 0 only below
+        Engine engine(config);
+        engine.start();
+        size_t producer = engine.register_producer();
+        for (int i = 0; i < 1000; ++i) {
+            Side side = i % 2 ? Side::SELL : Side::BUY;
+            Price price = px(i % 2 ? 100.0 + i % 7 * 0.01 : 100.05 - i % 7 * 0.01);
+            engine.submit(producer, Order(i + 1, i, side, OrderType::LIMIT, price, 1 + i % 3));
+        }
+        engine.submit(producer, Order(5000, 0, Side::BUY, OrderType::LIMIT, px(100.0), 0));     // no quantity
+        engine.submit(producer, Order(5001, 0, Side::BUY, OrderType::LIMIT, px(100.0), 101));   // risk limit
+        engine.submit(producer, Order(5002, 0, Side::BUY, OrderType::LIMIT, px(-1.0), 1));      // bad price
+        engine.stop();
+        assert(engine.matched() == 1003);
+        assert(seen.size() == 1000 && seen.front() == 1 && seen.back() == 1000);
+        static std::vector<DepthLevel> reference_bids, reference_asks;
+        auto bids = engine.book(0).depth(Side::BUY, 50), asks = engine.book(0).depth(Side::SELL, 50);
+        if (!pipelined) {
+            reference_bids = bids;
+            reference_asks = asks;
+        } else {
+            assert(bids.size() == reference_bids.size() && asks.size() == reference_asks.size());
+            for (size_t i = 0; i < bids.size(); ++i) assert(bids[i].price == reference_bids[i].price && bids[i].quantity == reference_bids[i].quantity);
+            for (size_t i = 0; i < asks.size(); ++i) assert(asks[i].price == reference_asks[i].price && asks[i].quantity == reference_asks[i].quantity);
+        }
+    }
+
+    // LatencyMetrics: histogram percentiles within one bucket (~3%), merged across threads
+    {
+        for (uint64_t ns : {0ull, 31ull, 32ull, 1000ull, 123456789ull}) {
+            size_t b = LatencyMetrics::bucket_of(ns);
+            assert(LatencyMetrics::bucket_high(b) >= ns && (b == 0 || LatencyMetrics::bucket_high(b - 1) < ns));
+        }
+        LatencyMetrics m;
+        std::thread other([&] { for (int i = 0; i < 500; ++i) m.add(100.0); });
+        for (int i = 1; i <= 500; ++i) m.add(i * 0.01);   // 0.01 .. 5.00 us
+        other.join();
+        LatencySummary s = m.summary();
+        assert(s.count == 1000 && s.max == 100.0 && s.min == 0.01);
+        assert(s.p50 >= 5.0 && s.p50 <= 5.0 * 1.04);
+        assert(s.p90 == 100.0 || (s.p90 >= 100.0 / 1.04 && s.p90 <= 100.0));
+        m.add(1.0, 9000);
+        assert(m.summary().p50 >= 1.0 && m.summary().p50 <= 1.04);
+
+        // Short-lived threads take over the recorder of an exited one; its samples stay counted.
+        // (`other` may have exited before the main thread's first add and left it its recorder.)
+        std::thread([&] { m.add(2.0); }).join();
+        size_t recorders = m.recorder_count();
+        for (int i = 0; i < 63; ++i) std::thread([&] { m.add(2.0); }).join();
+        assert(m.recorder_count() == recorders && m.summary().count == 10064);
+    }
+
+    // Journal: a restarted engine rebuilds its books from the journal; a torn record ends recovery
+    for (bool pipelined : {false, true}) {
+        const std::string dir = "/tmp/lob_test_journal";
+        std::filesystem::remove_all(dir);
+        EngineConfig config;
+        config.symbols = 2;
+        config.shards = 2;
+        config.pipelined = pipelined;
+        config.journal.dir = dir;
+        config.journal.durability = Durability::SYNC;
+        config.journal.segment_bytes = 64 * 100;   // Forces segment rotation
+        std::vector<DepthLevel> bids, asks;
+        {
+            Engine engine(config);
+            engine.start();
+            size_t producer = engine.register_producer();
+            for (int i = 0; i < 500; ++i) {
+                Side side = i % 2 ? Side::SELL : Side::BUY;
+                Order o(i + 1, i, side, OrderType::LIMIT, px(i % 2 ? 100.0 + i % 9 * 0.01 : 100.06 - i % 9 * 0.01), 1 + i % 4);
+                o.symbol_id = i % 2;
+                engine.submit(producer, o);
+                if (i % 10 == 9) engine.submit(producer, OrderMessage::cancel(i % 2, i - 4));
+            }
+            engine.submit(producer, Order(9999, 0, Side::BUY, OrderType::LIMIT, px(100.0), 0));   // rejected, not journaled
+            engine.stop();
+            JournalStats js = engine.journal_stats();
+            assert(js.records == 550 && js.segments > 2);
+            bids = engine.book(1).depth(Side::BUY, 50);
+            asks = engine.book(1).depth(Side::SELL, 50);
+        }
+        {
+            Engine engine(config);
+            engine.start();
+            engine.stop();
+            assert(engine.recovered() == 550);
+            auto b = engine.book(1).depth(Side::BUY, 50), a = engine.book(1).depth(Side::SELL, 50);
+            assert(b.size() == bids.size() && a.size() == asks.size());
+            for (size_t i = 0; i < b.size(); ++i) assert(b[i].price == bids[i].price && b[i].quantity == bids[i].quantity);
+            for (size_t i = 0; i < a.size(); ++i) assert(a[i].price == asks[i].price && a[i].quantity == asks[i].quantity);
+        }
+        // Corrupt shard 0's 10th record: recovery stops after the 9 before it
+        {
+            std::FILE* f = std::fopen((dir + "/shard0-00000000000000000001.wal").c_str(), "r+b");
+            std::fseek(f, sizeof(JournalSegmentHeader) + 9 * sizeof(JournalRecord) + 20, SEEK_SET);
+            std::fputc(0x5a, f);
+            std::fclose(f);
+            uint64_t last = Journal::recover(dir, 0, 0, [](uint64_t, const OrderMessage&) {});
+            assert(last == 9);
+        }
+        // Restarting on the torn journal drops the segments past record 9: a second restart
+        // replays the records journaled after the first and none of the old ones
+        {
+            size_t first_recovered;
+            {
+                Engine engine(config);
+                engine.start();
+                first_recovered = engine.recovered();
+                size_t producer = engine.register_producer();
+                for (int i = 0; i < 150; ++i) {   // Past the old segment boundaries of shard 0
+                    Order o(10000 + i, i, Side::BUY, OrderType::LIMIT, px(90.0 - i % 5 * 0.01), 1);
+                    o.symbol_id = 0;
+                    engine.submit(producer, o);
+                }
+                engine.stop();
+                bids = engine.book(0).depth(Side::BUY, 50);
+                asks = engine.book(0).depth(Side::SELL, 50);
+            }
+            Engine engine(config);
+            engine.start();
+            engine.stop();
+            assert(engine.recovered() == first_recovered + 150);
+            auto b = engine.book(0).depth(Side::BUY, 50), a = engine.book(0).depth(Side::SELL, 50);
+            assert(b.size() == bids.size() && a.size() == asks.size());
+            for (size_t i = 0; i < b.size(); ++i) assert(b[i].price == bids[i].price && b[i].quantity == bids[i].quantity);
+            for (size_t i = 0; i < a.size(); ++i) assert(a[i].price == asks[i].price && a[i].quantity == asks[i].quantity);
+        }
+        // With recovery off the old journal is discarded, not just its first segment
+        {
+            EngineConfig fresh = config;
+            fresh.journal.recover = false;
+            Engine engine(fresh);
+            engine.start();
+            size_t producer = engine.register_producer();
+            for (int i = 0; i < 3; ++i) {
+                Order o(20000 + i, i, Side::SELL, OrderType::LIMIT, px(110.0), 1);
+                o.symbol_id = i % 2;
+                engine.submit(producer, o);
+            }
+            engine.stop();
+        }
+        {
+            Engine engine(config);
+            engine.start();
+            engine.stop();
+            assert(engine.recovered() == 3);
+        }
+    }
+
+    // Snapshots: a restart loads the newest snapshot and replays only the journal after it;
+    // a damaged snapshot falls back to the one before
+    for (bool pipelined : {false, true}) {
+        const std::string dir = "/tmp/lob_test_snapshot";
+        std::filesystem::remove_all(dir);
+        EngineConfig config;
+        config.symbols = 2;
+        config.shards = 2;
+        config.pipelined = pipelined;
+        config.journal.dir = dir;
+        config.journal.segment_bytes = 64 * 50;
+        config.snapshot.keep = 2;
+        int next_id = 1;
+        auto submit = [&](Engine& engine, size_t producer, int n) {
+            for (int i = 0; i < n; ++i, ++next_id) {
+                Side side = next_id % 2 ? Side::SELL : Side::BUY;
+                Order o(next_id, next_id, side, OrderType::LIMIT, px(next_id % 2 ? 100.0 + next_id % 9 * 0.01 : 100.06 - next_id % 9 * 0.01), 1 + next_id % 4);
+                if (next_id % 25 == 0) {   // Pending stops, two per stop price
+                    o = Order(next_id, next_id, side, OrderType::STOP, Price(), 2, px(side == Side::BUY ? 150.0 : 50.0));
+                }
+                o.symbol_id = (next_id / 2) % 2;
+                engine.submit(producer, o);
+            }
+        };
+        auto snapshot_at = [&](Engine& engine, uint64_t messages, uint64_t written) {
+            while (engine.matched() < messages) std::this_thread::yield();
+            engine.request_snapshot();
+            while (engine.snapshot_stats().written < written) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        };
+        auto same_books = [](Engine& engine, std::vector<DepthLevel> (&levels)[2][2], std::vector<int> (&stops)[2]) {
+            for (uint32_t symbol = 0; symbol < 2; ++symbol) {
+                auto b = engine.book(symbol).depth(Side::BUY, 50), a = engine.book(symbol).depth(Side::SELL, 50);
+                assert(b.size() == levels[symbol][0].size() && a.size() == levels[symbol][1].size());
+                for (size_t i = 0; i < b.size(); ++i) assert(b[i].price == levels[symbol][0][i].price && b[i].quantity == levels[symbol][0][i].quantity);
+                for (size_t i = 0; i < a.size(); ++i) assert(a[i].price == levels[symbol][1][i].price && a[i].quantity == levels[symbol][1][i].quantity);
+                std::vector<int> ids;
+                for (const Order& o : engine.book(symbol).pending_stops()) ids.push_back(o.order_id);
+                assert(ids == stops[symbol]);
+            }
+        };
+        std::vector<DepthLevel> levels[2][2];
+        std::vector<int> stops[2];
+        {
+            Engine engine(config);
+            engine.start();
+            size_t producer = engine.register_producer();
+            submit(engine, producer, 300);
+            snapshot_at(engine, 300, 2);
+            submit(engine, producer, 100);
+            snapshot_at(engine, 400, 4);
+            submit(engine, producer, 100);
+            engine.stop();
+            SnapshotStats ss = engine.snapshot_stats();
+            assert(ss.written == 4 && ss.failed == 0);
+            for (uint32_t symbol = 0; symbol < 2; ++symbol) {
+                levels[symbol][0] = engine.book(symbol).depth(Side::BUY, 50);
+                levels[symbol][1] = engine.book(symbol).depth(Side::SELL, 50);
+                for (const Order& o : engine.book(symbol).pending_stops()) stops[symbol].push_back(o.order_id);
+                assert(stops[symbol].size() >= 4);   // The snapshots must carry stop ladders
+            }
+        }
+        assert(list_snapshots(dir, 0).size() == 2 && list_snapshots(dir, 1).size() == 2);
+        assert(!std::filesystem::exists(dir + "/shard0-00000000000000000001.wal"));   // Covered by both snapshots
+        {
+            Engine engine(config);
+            engine.start();
+            engine.stop();
+            assert(engine.restored() > 0 && engine.recovered() == 100);
+            same_books(engine, levels, stops);
+        }
+        // Damage shard 1's newest snapshot: it restarts from the older one and a longer tail
+        {
+            std::string newest = list_snapshots(dir, 1).back().second;
+            std::FILE* f = std::fopen(newest.c_str(), "r+b");
+            std::fseek(f, sizeof(SnapshotHeader) + sizeof(SnapshotBookHeader) + 8, SEEK_SET);
+            std::fputc(0x5a, f);
+            std::fclose(f);
+            Engine engine(config);
+            engine.start();
+            engine.stop();
+            assert(engine.recovered() == 150);
+            same_books(engine, levels, stops);
+        }
+    }
+
+    // Trade tape: every fill once, numbered on across files and restarts; replayed fills are not taped
+    for (bool pipelined : {false, true}) {
+        const std::string dir = "/tmp/lob_test_tape", journal_dir = "/tmp/lob_test_tape_journal";
+        std::filesystem::remove_all(dir);
+        std::filesystem::remove_all(journal_dir);
+        EngineConfig config;
+        config.symbols = 2;
+        config.shards = 2;
+        config.pipelined = pipelined;
+        config.journal.dir = journal_dir;
+        config.tape.dir = dir;
+        config.tape.segment_bytes = sizeof(TradeTapeHeader) + 30 * sizeof(TradeRecord);   // Forces rotation
+        int64_t traded[2] = {0, 0};
+        for (int run = 0; run < 2; ++run) {
+            Engine engine(config);
+            engine.start();
+            size_t producer = engine.register_producer();
+            for (int i = 0; i < 200; ++i) {
+                int id = run * 1000 + i + 1;
+                Side side = i % 2 ? Side::SELL : Side::BUY;
+                Order o(id, i, side, OrderType::LIMIT, px(100.0), 1 + i / 2 % 3);   // Every sell fills the buy before it
+                o.symbol_id = (i / 2) % 2;
+                engine.submit(producer, o);
+                if (side == Side::SELL) traded[o.symbol_id] += o.quantity;
+            }
+            engine.stop();
+            assert(engine.tape_stats().records == 100);
+        }
+        for (size_t shard = 0; shard < 2; ++shard) {
+            auto files = TradeTape::files(dir, shard);
+            assert(files.size() == 4 && files[1].first == 31 && files[2].first == 51);   // The second run starts a file
+            uint64_t next = 1;
+            int64_t quantity = 0;
+            for (const auto& [first, path] : files) {
+                MappedFile file(path);
+                TradeTapeReader reader(file.data(), file.size());
+                assert(reader.header().shard == shard && reader.header().first_trade == next && reader.tick_size() == DEFAULT_TICK_SIZE);
+                for (const TradeRecord& r : reader) {
+                    assert(r.trade_id == next++ && r.symbol == shard && Side(r.taker_side) == Side::SELL);
+                    assert(r.maker_id == r.taker_id - 1 && r.price == px(100.0).ticks && r.latency_ns >= 0);
+                    quantity += r.quantity;
+                }
+            }
+            assert(next == 101 && quantity == traded[shard]);
+        }
+    }
+    assert(!std::filesystem::exists("latency.csv"));
+
+    // CSV replay: field parsing, decimal prices to ticks, header/comment skipping, a final line without newline
+    {
+        const char* csv =
+            "timestamp_ns,action,order_id,symbol,side,type,price,quantity,stop_price\n"
+            "1000,A,1,2,B,L,100.05,10,\n"
+            "# comment\n"
+            "\n"
+            "2000,A,2,0,S,T,99.5,3,99.504\r\n"
+            "3000,M,1,2,,,100.1,7,\n"
+            "4000,C,1,2,,,,,\n"
+            "5000,A,3,1,S,M,,4";
+        CsvOrderParser parser(csv, csv + std::strlen(csv));
+        OrderMessage m = OrderMessage::cancel(0, 0);
+        assert(parser.next(m) && m.type == MessageType::NEW);
+        assert(m.order.order_id == 1 && m.order.symbol_id == 2 && m.order.timestamp == 1000);
+        assert(m.order.side == Side::BUY && m.order.type == OrderType::LIMIT && m.order.price == Price(10005) && m.order.quantity == 10);
+        assert(parser.next(m) && m.order.type == OrderType::STOP_LIMIT && m.order.side == Side::SELL);
+        assert(m.order.price == Price(9950) && m.order.stop_price == Price(9950));
+        assert(parser.next(m) && m.type == MessageType::MODIFY && m.order.price == Price(10010) && m.order.quantity == 7);
+        assert(parser.next(m) && m.type == MessageType::CANCEL && m.order.order_id == 1 && m.order.timestamp == 4000);
+        assert(parser.next(m) && m.order.type == OrderType::MARKET && m.order.quantity == 4 && m.order.symbol_id == 1);
+        assert(!parser.next(m) && parser.bytes_consumed() == std::strlen(csv));
+
+        const char* bad = "1000,A,1,0,X,L,100,1,\n";
+        CsvOrderParser bad_parser(bad, bad + std::strlen(bad));
+        bool threw = false;
+        try { bad_parser.next(m); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+
+        // A line cut short after a one-character field is rejected without reading past its
+        // newline: at the very end of the input, and before another line
+        for (const char* cut : {"1,A,5,0,\n", "1,A,5,0,B\n", "1,A,5,0,B,\n", "1,\n", "1,A,5,0,\n2,A,6,0,B,L,100,1,\n"}) {
+            std::vector<char> exact(cut, cut + std::strlen(cut));   // No terminator past the end
+            CsvOrderParser cut_parser(exact.data(), exact.data() + exact.size());
+            threw = false;
+            try { cut_parser.next(m); } catch (const std::runtime_error&) { threw = true; }
+            assert(threw && cut_parser.line() == 1);
+        }
+
+        // Binary event file: round trip of every event kind, read in place; bad headers rejected
+        {
+            const char* path = "/tmp/lob_test_events.bin";
+            std::vector<OrderMessage> written;
+            CsvOrderParser again(csv, csv + std::strlen(csv));
+            EventFileWriter writer(path, {"AAA", "BBB", "CCC"});
+            while (again.next(m)) {
+                written.push_back(m);
+                writer.append(m);
+            }
+            writer.close();
+            MappedFile file(path);
+            EventFileReader reader(file.data(), file.size());
+            assert(reader.size() == written.size() && reader.symbol_count() == 3 && reader.symbol(1) == "BBB");
+            assert(reader.tick_size() == DEFAULT_TICK_SIZE);
+            for (const OrderMessage& w : written) {
+                assert(reader.next(m));
+                assert(m.type == w.type && m.order.order_id == w.order.order_id && m.order.symbol_id == w.order.symbol_id);
+                assert(m.order.timestamp == w.order.timestamp && m.order.price == w.order.price && m.order.quantity == w.order.quantity);
+                if (w.type == MessageType::NEW) {
+                    assert(m.order.side == w.order.side && m.order.type == w.order.type && m.order.stop_price == w.order.stop_price);
+                }
+            }
+            assert(!reader.next(m) && reader.bytes_consumed() == file.size());
+
+            std::vector<char> bytes(file.data(), file.end());
+            bytes[8] = 99;   // version
+            threw = false;
+            try { EventFileReader bad_version(bytes.data(), bytes.size()); } catch (const std::runtime_error&) { threw = true; }
+            assert(threw);
+            threw = false;
+            try { EventFileReader truncated(file.data(), file.size() - 1); } catch (const std::runtime_error&) { threw = true; }
+            assert(threw);
+            assert(!EventFileReader::is_event_file(csv, std::strlen(csv)));
+            std::remove(path);
+        }
+
+        // The shipped sample replays into an engine without rejects for known symbols
+        MappedFile file("data/sample_orders.csv");
+        CsvOrderParser sample(file.data(), file.end());
+        EngineConfig config;
+        config.symbols = 4;
+        Engine engine(config);
+        engine.start();
+        size_t producer = engine.register_producer();
+        ReplayStats stats = replay(sample, [&](const OrderMessage& msg) { engine.submit(producer, msg); return true; });
+        engine.stop();
+        assert(stats.messages > 0 && engine.matched() == stats.messages && stats.bytes == file.size());
+    }
+
+    // Logger: rings of exited threads are reused once drained, so short-lived threads do not add rings
+    {
+        Logger& logger = Logger::instance();
+        std::thread([&] { logger.ring(); }).join();
+        logger.flush();
+        size_t before = logger.rings_allocated();
+        for (int i = 0; i < 64; ++i) {
+            std::thread([&] { logger.ring(); }).join();
+            logger.flush();   // The writer pass that completes the flush reclaims the ring
+        }
+        assert(logger.rings_allocated() == before);
+    }
 
     std::cout << "All tests ran. Please check output for correct triggering and fills.\n";
     return 0;
@@ -0,0 +1,87 @@
+#include "order_book.hpp"
+#include "matcher.hpp"
+#include "alloc_counter.hpp"
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+
+// Replays a steady-state add/cancel/modify/match workload on a dedicated matching
+// thread and fails if that thread calls operator new once the book is warmed up.
+
+static const int MAX_LIVE = 4096;
+
+struct Replay {
+    OrderBook& book;
+    Matcher matcher;
+    std::mt19937 rng{7};
+    int live[MAX_LIVE];
+    int live_count = 0;
+    int next_id = 1;
+
+    explicit Replay(OrderBook& b) : book(b) {}
+
+    Price random_price(Side side) {
+        // Bids rest in [95, 100), asks in (100, 105]; a few crossing orders hit the other side
+        int offset = 1 + rng() % 500;
+        return side == Side::BUY ? Price(10000 - offset) : Price(10000 + offset);
+    }
+
+    void step() {
+        int action = rng() % 10;
+        if (live_count > 0 && action < 5) {
+            int slot = rng() % live_count;
+            OrderHandle h = book.order_index.find(live[slot]);
+            if (h == NULL_HANDLE) {
+                // Already filled away by the matcher
+                live[slot] = live[--live_count];
+            } else if (action < 3) {
+                book.cancel_order(live[slot]);
+                live[slot] = live[--live_count];
+            } else {
+                // Modify price and size (may or may not keep priority)
+                Side side = book.orders[h].side;
+                book.modify_order(live[slot], random_price(side), 1 + rng() % 20);
+            }
+        } else if (action < 6) {
+            // Aggressive order that sweeps a few levels through the matcher
+            int id = next_id++;
+            Side side = rng() % 2 ? Side::BUY : Side::SELL;
+            Price limit = side == Side::BUY ? Price(10500) : Price(9500);
+            Order o(id, id, side, OrderType::LIMIT, limit, 1 + rng() % 50);
+            matcher.match_order(o, book);
+            book.cancel_order(id);  // do not let the remainder rest
+        } else if (live_count < MAX_LIVE) {
+            // Passive limit order
+            int id = next_id++;
+            Side side = rng() % 2 ? Side::BUY : Side::SELL;
+            book.add_order(Order(id, id, side, OrderType::LIMIT, random_price(side), 1 + rng() % 20));
+            live[live_count++] = id;
+        }
+    }
+};
+
+int main() {
+    // Per-event console output is not part of what this test measures
+    std::cout.setstate(std::ios::badbit);
+
+    BookConfig config;
+    config.max_orders = MAX_LIVE * 2;
+    OrderBook book(config);
+    size_t allocations = 0;
+
+    std::thread matching_thread([&] {
+        Replay replay(book);
+        for (int i = 0; i < 50000; ++i) replay.step();  // warm-up: open files, fill pools
+
+        AllocGuard guard;
+        for (int i = 0; i < 200000; ++i) replay.step();
+        allocations = guard.count();
+    });
+    matching_thread.join();
+
+    std::printf("Allocations on matching thread during replay: %zu\n", allocations);
+    assert(allocations == 0);
+    return allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include "csv_replay.hpp"
+#include "event_file.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Convert a CSV order-flow file (csv_replay.hpp) to the binary event format
+// (event_file.hpp):
+//
+//   csv2bin <in.csv> <out.bin> [--tick 0.01] [--symbols NAME0,NAME1,...]
+//
+// Without --symbols, symbol i is named after its number.
+
+static int usage() {
+    std::fprintf(stderr, "usage: csv2bin <in.csv> <out.bin> [--tick SIZE] [--symbols NAME0,NAME1,...]\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) return usage();
+    std::string in = argv[1], out = argv[2];
+    double tick_size = DEFAULT_TICK_SIZE;
+    std::vector<std::string> symbols;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--tick" && i + 1 < argc) {
+            tick_size = std::atof(argv[++i]);
+            if (!(tick_size > 0)) return usage();
+        } else if (arg == "--symbols" && i + 1 < argc) {
+            std::string list = argv[++i];
+            for (size_t start = 0; start <= list.size();) {
+                size_t comma = std::min(list.find(',', start), list.size());
+                symbols.push_back(list.substr(start, comma - start));
+                start = comma + 1;
+            }
+        } else {
+            return usage();
+        }
+    }
+
+    try {
+        MappedFile csv(in);
+        OrderMessage m = OrderMessage::cancel(0, 0);
+        if (symbols.empty()) {
+            // First pass: size the symbol table from the highest symbol id
+            uint32_t max_symbol = 0;
+            CsvOrderParser scan(csv.data(), csv.end(), tick_size);
+            while (scan.next(m)) max_symbol = std::max(max_symbol, m.order.symbol_id);
+            for (uint32_t s = 0; s <= max_symbol; ++s) symbols.push_back(std::to_string(s));
+        }
+        EventFileWriter writer(out, symbols, tick_size);
+        CsvOrderParser parser(csv.data(), csv.end(), tick_size);
+        while (parser.next(m)) writer.append(m);
+        writer.close();
+        std::printf("%s: %llu events, %zu symbols, %zu -> %llu bytes\n", out.c_str(), (unsigned long long)writer.events(),
+                    symbols.size(), csv.size(), (unsigned long long)std::filesystem::file_size(out));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "csv2bin: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "trade_tape.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Export trade tape files (trade_tape.hpp) as CSV on stdout:
+//
+//   tape2csv <file.tape | dir> ...
+//
+// A directory stands for all of its .tape files. Files are exported per shard, in trade order.
+
+static int usage() {
+    std::fprintf(stderr, "usage: tape2csv <file.tape | dir> ...\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) return usage();
+    try {
+        std::vector<std::string> paths;
+        for (int i = 1; i < argc; ++i) {
+            if (!std::filesystem::is_directory(argv[i])) {
+                paths.push_back(argv[i]);
+                continue;
+            }
+            for (const auto& entry : std::filesystem::directory_iterator(argv[i])) {
+                if (entry.path().extension() == ".tape") paths.push_back(entry.path().string());
+            }
+        }
+        // Order by (shard, first trade) from the headers
+        std::vector<std::tuple<uint64_t, uint64_t, std::string>> files;
+        for (const std::string& path : paths) {
+            MappedFile file(path);
+            TradeTapeReader reader(file.data(), file.size());
+            files.emplace_back(reader.header().shard, reader.header().first_trade, path);
+        }
+        std::sort(files.begin(), files.end());
+
+        std::printf("shard,trade_id,timestamp_ns,symbol,taker_side,taker_id,maker_id,price,quantity,latency_ns\n");
+        for (const auto& [shard, first_trade, path] : files) {
+            MappedFile file(path);
+            TradeTapeReader reader(file.data(), file.size());
+            for (const TradeRecord& r : reader) {
+                std::printf("%llu,%llu,%lld,%u,%c,%d,%d,%.10g,%d,%lld\n", (unsigned long long)shard,
+                            (unsigned long long)r.trade_id, (long long)r.timestamp_ns, r.symbol,
+                            Side(r.taker_side) == Side::BUY ? 'B' : 'S', r.taker_id, r.maker_id,
+                            Price(r.price).to_double(reader.tick_size()), r.quantity, (long long)r.latency_ns);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "tape2csv: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
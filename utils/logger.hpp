@@ -0,0 +1,294 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Asynchronous binary logger.
+//
+// A log call copies a timestamp, a pointer to the (static) format string and up to
+// LOG_MAX_ARGS scalar arguments into a fixed-size record on the calling thread's own
+// ring buffer; nothing is formatted and no lock is taken. A background thread drains
+// every ring, formats the records and writes them to std::cout. If a ring is full the
+// record is dropped and counted rather than blocking the caller. Once a thread has exited
+// and its ring is drained, the ring is handed to the next thread that starts logging.
+//
+// Format strings use "{}" placeholders and must outlive the logger (string literals).
+// String arguments are stored by pointer, so they must be literals as well.
+//
+// Levels below LOB_LOG_LEVEL are removed at compile time:
+//   0 = DEBUG, 1 = INFO (default), 2 = WARN, 3 = ERROR, 4 = off.
+
+#ifndef LOB_LOG_LEVEL
+#define LOB_LOG_LEVEL 1
+#endif
+
+enum class LogLevel : uint8_t { DEBUG = 0, INFO = 1, WARN = 2, ERROR = 3 };
+
+constexpr size_t LOG_MAX_ARGS = 5;
+
+// One argument of a log record, tagged with its type.
+struct LogArg {
+    enum Type : uint8_t { INT, UINT, DOUBLE, STR };
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char* s;
+    };
+};
+
+// Fixed-size log record: one cache line.
+struct alignas(64) LogRecord {
+    uint64_t timestamp;              // Raw clock ticks (TSC where available)
+    const char* format;              // Static format string with {} placeholders
+    LogLevel level;
+    uint8_t arg_count;
+    LogArg::Type types[LOG_MAX_ARGS];
+    LogArg args[LOG_MAX_ARGS];
+};
+static_assert(sizeof(LogRecord) == 64, "log record must stay one cache line");
+
+// Single-producer/single-consumer ring of log records owned by one logging thread.
+class LogRing {
+public:
+    static constexpr size_t CAPACITY = 1 << 14;  // Records per thread (1 MiB)
+
+    LogRecord* try_claim() {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t - head_cache == CAPACITY) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t - head_cache == CAPACITY) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+        return &records[t & (CAPACITY - 1)];
+    }
+    void publish() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Consumer side: visit every published record, then free them.
+    template <typename F>
+    size_t drain(F&& f) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        for (uint64_t i = h; i != t; ++i) f(records[i & (CAPACITY - 1)]);
+        head.store(t, std::memory_order_release);
+        return t - h;
+    }
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> retired{false};            // Set when the owning thread exits
+
+private:
+    alignas(64) std::atomic<uint64_t> head{0};   // Next record to format (consumer)
+    alignas(64) std::atomic<uint64_t> tail{0};   // Next free record (producer)
+    uint64_t head_cache = 0;                     // Producer's last view of head
+    std::unique_ptr<LogRecord[]> records{new LogRecord[CAPACITY]};
+};
+
+inline uint64_t log_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+class Logger {
+public:
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    // Ring of the calling thread, taken on its first log call: a reclaimed one if any,
+    // else a new one. The ring is retired when the thread exits.
+    LogRing& ring() {
+        thread_local RingOwner owner;
+        if (!owner.ring) {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            if (!free_rings.empty()) {
+                owner.ring = free_rings.back();
+                free_rings.pop_back();
+            } else {
+                rings.push_back(std::make_unique<LogRing>());
+                owner.ring = rings.back().get();
+                ring_count.store(rings.size(), std::memory_order_release);
+            }
+        }
+        return *owner.ring;
+    }
+
+    // Rings allocated so far: at most the number of threads logging at the same time.
+    size_t rings_allocated() const { return ring_count.load(std::memory_order_acquire); }
+
+    // Block until every record logged before the call has been written.
+    void flush() {
+        uint64_t target = flush_requests.fetch_add(1) + 1;
+        while (flushed.load(std::memory_order_acquire) < target) std::this_thread::yield();
+    }
+
+    // Background writer thread, e.g. to pin it away from the matcher.
+    std::thread::native_handle_type native_handle() { return worker.native_handle(); }
+
+    ~Logger() {
+        running.store(false, std::memory_order_release);
+        if (worker.joinable()) worker.join();
+    }
+
+private:
+    struct RingOwner {
+        LogRing* ring = nullptr;
+        ~RingOwner() { if (ring) ring->retired.store(true, std::memory_order_release); }
+    };
+
+    std::mutex rings_mutex;
+    std::vector<std::unique_ptr<LogRing>> rings;   // Every ring allocated, in use or free
+    std::vector<LogRing*> free_rings;              // Retired and drained, ready for reuse
+    std::atomic<size_t> ring_count{0};
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> flush_requests{0}, flushed{0};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t start_ticks = log_clock();
+    std::thread worker;
+
+    Logger() : worker([this] { run(); }) {}
+
+    static const char* level_name(LogLevel level) {
+        switch (level) {
+            case LogLevel::DEBUG: return "DEBUG";
+            case LogLevel::INFO:  return "INFO ";
+            case LogLevel::WARN:  return "WARN ";
+            default:              return "ERROR";
+        }
+    }
+
+    static void append_arg(std::string& out, LogArg::Type type, const LogArg& arg) {
+        char buf[32];
+        switch (type) {
+            case LogArg::INT:    std::snprintf(buf, sizeof(buf), "%lld", (long long)arg.i); break;
+            case LogArg::UINT:   std::snprintf(buf, sizeof(buf), "%llu", (unsigned long long)arg.u); break;
+            case LogArg::DOUBLE: std::snprintf(buf, sizeof(buf), "%g", arg.d); break;
+            case LogArg::STR:    out += arg.s; return;
+        }
+        out += buf;
+    }
+
+    void format(std::string& out, const LogRecord& r, double seconds) {
+        char prefix[48];
+        std::snprintf(prefix, sizeof(prefix), "[%12.6f] %s ", seconds, level_name(r.level));
+        out += prefix;
+        size_t next = 0;
+        for (const char* p = r.format; *p; ++p) {
+            if (p[0] == '{' && p[1] == '}' && next < r.arg_count) {
+                append_arg(out, r.types[next], r.args[next]);
+                ++next;
+                ++p;
+            } else {
+                out += *p;
+            }
+        }
+        out += '\n';
+    }
+
+    // Background thread: drain all rings, format, write. Timestamps are printed as
+    // seconds since the logger started; the tick rate is re-estimated on every pass.
+    // A ring retired before it was drained is empty afterwards and goes on the free list.
+    void run() {
+        std::string out;
+        std::vector<uint64_t> reported_drops;
+        while (true) {
+            bool stopping = !running.load(std::memory_order_acquire);
+            uint64_t flush_target = flush_requests.load(std::memory_order_acquire);
+            double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            uint64_t ticks = log_clock() - start_ticks;
+            double ns_per_tick = ticks ? elapsed_ns / ticks : 1.0;
+
+            size_t count = ring_count.load(std::memory_order_acquire);
+            size_t drained = 0;
+            for (size_t i = 0; i < count; ++i) {
+                LogRing* r;
+                {
+                    std::lock_guard<std::mutex> lock(rings_mutex);
+                    r = rings[i].get();
+                }
+                bool retired = r->retired.load(std::memory_order_acquire);
+                drained += r->drain([&](const LogRecord& rec) {
+                    double seconds = (int64_t)(rec.timestamp - start_ticks) * ns_per_tick * 1e-9;
+                    format(out, rec, seconds);
+                });
+                if (reported_drops.size() <= i) reported_drops.resize(i + 1, 0);
+                uint64_t dropped = r->dropped.load(std::memory_order_relaxed);
+                if (dropped != reported_drops[i]) {
+                    out += "[logger] " + std::to_string(dropped - reported_drops[i]) + " records dropped (ring full)\n";
+                    reported_drops[i] = dropped;
+                }
+                if (retired) {
+                    std::lock_guard<std::mutex> lock(rings_mutex);
+                    r->retired.store(false, std::memory_order_relaxed);
+                    free_rings.push_back(r);
+                }
+            }
+            if (!out.empty()) {
+                std::cout.write(out.data(), out.size());
+                std::cout.flush();
+                out.clear();
+            }
+            flushed.store(flush_target, std::memory_order_release);
+            if (stopping) break;
+            if (drained == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+};
+
+inline LogArg::Type log_arg(LogArg& a, const char* v) { a.s = v; return LogArg::STR; }
+inline LogArg::Type log_arg(LogArg& a, double v) { a.d = v; return LogArg::DOUBLE; }
+template <typename T>
+inline LogArg::Type log_arg(LogArg& a, T v) {
+    static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "log arguments must be scalars or string literals");
+    if constexpr (std::is_signed_v<T>) {
+        a.i = static_cast<int64_t>(v);
+        return LogArg::INT;
+    } else {
+        a.u = static_cast<uint64_t>(v);
+        return LogArg::UINT;
+    }
+}
+
+template <typename... Args>
+inline void log_write(LogLevel level, const char* format, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+    LogRing& ring = Logger::instance().ring();
+    LogRecord* r = ring.try_claim();
+    if (!r) return;
+    r->timestamp = log_clock();
+    r->format = format;
+    r->level = level;
+    r->arg_count = sizeof...(Args);
+    size_t i = 0;
+    ((r->types[i] = log_arg(r->args[i], args), ++i), ...);
+    ring.publish();
+}
+
+#define LOB_LOG(level, ...) \
+    do { \
+        if constexpr (static_cast<int>(level) >= LOB_LOG_LEVEL) log_write(level, __VA_ARGS__); \
+    } while (0)
+
+#define LOG_DEBUG(...) LOB_LOG(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  LOB_LOG(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARN(...)  LOB_LOG(LogLevel::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOB_LOG(LogLevel::ERROR, __VA_ARGS__)